@@ -0,0 +1,367 @@
+/*
+	Parse-throughput benchmark
+
+	Generates a synthetic configuration deck, reads it repeatedly with each
+	ReadConfig overload and reports throughput, allocations and peak memory.
+	Run `bench.out --help` for the deck options.
+*/
+#include "parselib.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <thread>
+#include <sys/resource.h> //getrusage
+
+//Every allocation made by the process, so allocations per line can be reported
+static std::atomic<std::uint64_t> Allocations{0};
+
+void* operator new(std::size_t n)
+{
+	Allocations.fetch_add(1,std::memory_order_relaxed);
+	if (void* p = std::malloc(n ? n : 1))
+		return p;
+	throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {return operator new(n);}
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete[](void* p) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::size_t) noexcept {std::free(p);}
+
+/** @brief Shape of a generated deck */
+struct DeckOptions
+{
+	std::size_t Keys = 200000;     ///<Number of values in the whole deck
+	unsigned IntWeight = 40;       ///<Relative share of integer values
+	unsigned DoubleWeight = 40;    ///<Relative share of double values
+	unsigned StringWeight = 20;    ///<Relative share of string values
+	std::size_t LineLength = 32;   ///<Approximate length of every value and comment line
+	double CommentDensity = 0.1;   ///<Fraction of lines that are comments
+	unsigned IncludeDepth = 0;     ///<Number of nested includes the values are spread across
+	unsigned Seed = 1;
+	std::string Dir = "bench_deck"; ///<Directory the deck is written to
+};
+
+/** @brief Size of a generated deck */
+struct DeckInfo
+{
+	std::string Top;         ///<File to read
+	std::size_t Bytes = 0;   ///<Bytes in every file of the deck
+	std::size_t Lines = 0;   ///<Lines in every file of the deck
+};
+
+/**
+ * @brief Writes a synthetic deck
+ * @param O             Shape of the deck
+ * @return Name and size of the deck
+ *
+ * The values are split evenly over `IncludeDepth + 1` files, each of which
+ * includes the next one halfway through.  Numeric lines reach the line
+ * length through long key names, string lines through long values.
+ */
+static DeckInfo GenerateDeck(DeckOptions const &O)
+{
+	std::mt19937 Rng(O.Seed);
+	std::uniform_real_distribution<double> Unit(0.0,1.0);
+	unsigned TotalWeight = std::max(1u,O.IntWeight + O.DoubleWeight + O.StringWeight);
+	std::filesystem::create_directories(O.Dir);
+
+	DeckInfo Info;
+	unsigned Files = O.IncludeDepth + 1;
+	std::size_t Key = 0;
+	for (unsigned f = 0; f < Files; f++) {
+		std::string FileName = O.Dir + "/deck_" + std::to_string(f) + ".in";
+		if (f == 0)
+			Info.Top = FileName;
+		std::string Text;
+		std::size_t Count = O.Keys / Files + (f < O.Keys % Files ? 1 : 0);
+		for (std::size_t i = 0; i < Count; i++, Key++) {
+			if (f + 1 < Files && i == Count / 2) {
+				Text += "include " + O.Dir + "/deck_" + std::to_string(f + 1) + ".in\n";
+				Info.Lines++;
+			}
+			if (Unit(Rng) < O.CommentDensity) {
+				Text += "# " + std::string(O.LineLength > 2 ? O.LineLength - 2 : 0,'c') + "\n";
+				Info.Lines++;
+			}
+			std::string KeyName = "KEY_" + std::to_string(Key);
+			std::string Value;
+			unsigned Pick = Rng() % TotalWeight;
+			if (Pick < O.IntWeight) {
+				Value = std::to_string(static_cast<int>(Rng() % 2000000) - 1000000);
+			} else if (Pick < O.IntWeight + O.DoubleWeight) {
+				char Buffer[32];
+				std::snprintf(Buffer,sizeof(Buffer),(Rng() % 4 == 0) ? "%.6e" : "%.6f",(Unit(Rng) - 0.5) * 1000.0);
+				Value = Buffer;
+			} else {
+				std::size_t Length = O.LineLength > KeyName.length() + 1 ? O.LineLength - KeyName.length() - 1 : 1;
+				for (std::size_t c = 0; c < Length; c++) //A value ends at the first blank, so use '_' between words
+					Value += (c % 8 == 7) ? '_' : static_cast<char>('a' + Rng() % 26);
+			}
+			if (KeyName.length() + 1 + Value.length() < O.LineLength)
+				KeyName.append(O.LineLength - KeyName.length() - 1 - Value.length(),'_');
+			Text += KeyName + " " + Value + "\n";
+			Info.Lines++;
+		}
+		std::ofstream f_out(FileName,std::ofstream::binary | std::ofstream::trunc);
+		f_out << Text;
+		Info.Bytes += Text.length();
+	}
+	return Info;
+}
+
+/** @brief Peak resident set size of the process, in MiB */
+static double PeakRSS()
+{
+	struct rusage Usage;
+	getrusage(RUSAGE_SELF,&Usage);
+#ifdef __APPLE__
+	return Usage.ru_maxrss / (1024.0 * 1024.0); //bytes
+#else
+	return Usage.ru_maxrss / 1024.0; //KiB
+#endif
+}
+
+/**
+ * @brief Times one way of reading the deck and prints a result row
+ * @param Label         Name of the row
+ * @param Info          Deck being read
+ * @param Repeat        Number of timed reads (the fastest is reported)
+ * @param Read          Reads the deck into a Dict
+ */
+template <class Reader>
+static void Run(const char* Label, DeckInfo const &Info, unsigned Repeat, Reader Read)
+{
+	double Best = 1e300;
+	std::uint64_t Allocs = 0;
+	double PerEntry = 0.0;
+	for (unsigned r = 0; r < Repeat; r++) {
+		ParseLi::Dict D;
+		std::uint64_t Before = Allocations.load();
+		auto t0 = std::chrono::steady_clock::now();
+		bool ok = Read(D);
+		auto t1 = std::chrono::steady_clock::now();
+		Allocs = Allocations.load() - Before;
+		PerEntry = D.Memory().PerEntry();
+		if (!ok) {
+			std::printf("%-40s read failed\n",Label);
+			return;
+		}
+		Best = std::min(Best,std::chrono::duration<double>(t1 - t0).count());
+	}
+	std::printf("%-40s %9.1f MB/s %9.2f Mlines/s %8.3f allocs/line %7.1f B/entry %9.1f MiB peak RSS\n",Label,
+		Info.Bytes / Best / 1e6,Info.Lines / Best / 1e6,static_cast<double>(Allocs) / Info.Lines,PerEntry,PeakRSS());
+}
+
+/**
+ * @brief Times threads updating and reading their own key in one dictionary and prints a result row
+ * @param Label         Name of the row
+ * @param D             Dict or ConcurrentDict to update
+ * @param Threads       Number of threads
+ * @param Updates       Updates per thread (each followed by two reads)
+ */
+template <class Dictionary>
+static void RunUpdates(const char* Label, Dictionary &D, unsigned Threads, std::size_t Updates)
+{
+	D.set("SHARED",1);
+	std::vector<std::thread> Workers;
+	std::atomic<long> Sink{0};
+	auto t0 = std::chrono::steady_clock::now();
+	for (unsigned t = 0; t < Threads; t++) {
+		Workers.emplace_back([&D,&Sink,t,Updates] {
+			std::string Key = "PARAM_" + std::to_string(t);
+			long Sum = 0;
+			for (std::size_t i = 0; i < Updates; i++) {
+				D.set(Key,static_cast<double>(i));
+				Sum += static_cast<long>(D.GetDouble(Key)) + D.GetInt("SHARED");
+			}
+			Sink += Sum;
+		});
+	}
+	for (std::thread &w : Workers)
+		w.join();
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	std::printf("%-40s %9.2f Mops/s (%u threads, 1 update + 2 reads per op)\n",Label,Threads * Updates / Seconds / 1e6,Threads);
+}
+
+/**
+ * @brief Times lookups of the deck's keys, each with its own type, in random order
+ * @param Label         Name of the case
+ * @param F             Snapshot to look the keys up in
+ * @param Keys          Keys of the deck and their types
+ * @param Lookups       Number of lookups to time
+ */
+static void RunLookups(const char* Label, ParseLi::FrozenDict const &F, std::vector<ParseLi::DictEntry> const &Keys, std::size_t Lookups)
+{
+	std::mt19937 Rng(7);
+	std::vector<std::uint32_t> Pick(Lookups);
+	for (std::uint32_t &k : Pick)
+		k = static_cast<std::uint32_t>(Rng() % Keys.size());
+	std::size_t Found = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (std::uint32_t k : Pick) {
+		ParseLi::DictEntry const &E = Keys[k];
+		switch (E.Type) {
+			case ParseLi::ValueType::Int: Found += F.TryGetInt(E.Key).has_value(); break;
+			case ParseLi::ValueType::Double: Found += F.TryGetDouble(E.Key).has_value(); break;
+			case ParseLi::ValueType::String: Found += F.TryGetString(E.Key).has_value(); break;
+			default: Found += F.CheckDoubleArray(E.Key); break;
+		}
+	}
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	std::printf("%-40s %9.2f Mlookups/s (%zu of %zu found)\n",Label,Lookups / Seconds / 1e6,Found,Lookups);
+}
+
+/**
+ * @brief Times lookups of the deck's keys in a Dict, one call per key or batched through Dict::GetMany()
+ * @param Label         Name of the case
+ * @param D             Dictionary to look the keys up in
+ * @param Keys          Keys of the deck and their types
+ * @param Lookups       Number of lookups to time
+ * @param Batch         Keys per Dict::GetMany() call (0: one TryGet... call per key)
+ */
+static void RunDictLookups(const char* Label, ParseLi::Dict const &D, std::vector<ParseLi::DictEntry> const &Keys, std::size_t Lookups, std::size_t Batch)
+{
+	std::mt19937 Rng(7);
+	std::vector<ParseLi::KeyRequest> Requests(Lookups);
+	for (ParseLi::KeyRequest &R : Requests) {
+		ParseLi::DictEntry const &E = Keys[Rng() % Keys.size()];
+		R.Key = E.Key;
+		R.Type = E.Type;
+	}
+	std::vector<ParseLi::KeyResult> Results(std::max<std::size_t>(Batch,1));
+	std::size_t Found = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	if (Batch == 0) {
+		for (ParseLi::KeyRequest const &R : Requests) {
+			switch (R.Type) {
+				case ParseLi::ValueType::Int: Found += D.TryGetInt(R.Key).has_value(); break;
+				case ParseLi::ValueType::Double: Found += D.TryGetDouble(R.Key).has_value(); break;
+				case ParseLi::ValueType::String: Found += D.TryGetString(R.Key).has_value(); break;
+				default: Found += D.TryGetDoubleArray(R.Key).has_value(); break;
+			}
+		}
+	}
+	else {
+		for (std::size_t i = 0; i < Lookups; i += Batch) {
+			std::size_t n = std::min(Batch,Lookups - i);
+			Found += D.GetMany(ParseLi::Span<const ParseLi::KeyRequest>(Requests.data() + i,n),
+				ParseLi::Span<ParseLi::KeyResult>(Results.data(),n));
+		}
+	}
+	double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	std::printf("%-40s %9.2f Mlookups/s (%zu of %zu found)\n",Label,Lookups / Seconds / 1e6,Found,Lookups);
+}
+
+static void Usage()
+{
+	std::puts("Usage: bench.out [options]\n"
+		"  --keys N            values in the deck (200000)\n"
+		"  --mix I:D:S         relative shares of int, double and string values (40:40:20)\n"
+		"  --line-length N     approximate length of each line (32)\n"
+		"  --comments F        fraction of lines that are comments (0.1)\n"
+		"  --include-depth N   nested include files the values are spread over (0)\n"
+		"  --threads N         also read with ReadOptions::IncludeThreads = N, with and without io_uring (0: skip)\n"
+		"  --parse-threads N   also read with ReadOptions::ParseThreads = N (0: skip)\n"
+		"  --set-threads N     also time N threads calling set/Get on Dict and ConcurrentDict (0: skip)\n"
+		"  --lookups N         also time N lookups in a Dict (one by one and batched) and a FrozenDict (0: skip)\n"
+		"  --repeat N          timed reads per case; the fastest is reported (5)\n"
+		"  --seed N            random seed (1)\n"
+		"  --dir PATH          where the deck is written (bench_deck)\n"
+		"  --generate          only write the deck");
+}
+
+int main(int argc, char** argv)
+{
+	DeckOptions O;
+	unsigned Threads = 0;
+	unsigned ParseThreads = 0;
+	unsigned SetThreads = 0;
+	std::size_t Lookups = 0;
+	unsigned Repeat = 5;
+	bool GenerateOnly = false;
+	for (int i = 1; i < argc; i++) {
+		std::string Arg = argv[i];
+		const char* Next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		bool Used = (Next != nullptr);
+		if (Arg == "--keys" && Next) O.Keys = std::strtoull(Next,nullptr,10);
+		else if (Arg == "--mix" && Next) Used = std::sscanf(Next,"%u:%u:%u",&O.IntWeight,&O.DoubleWeight,&O.StringWeight) == 3;
+		else if (Arg == "--line-length" && Next) O.LineLength = std::strtoull(Next,nullptr,10);
+		else if (Arg == "--comments" && Next) O.CommentDensity = std::strtod(Next,nullptr);
+		else if (Arg == "--include-depth" && Next) O.IncludeDepth = std::strtoul(Next,nullptr,10);
+		else if (Arg == "--threads" && Next) Threads = std::strtoul(Next,nullptr,10);
+		else if (Arg == "--parse-threads" && Next) ParseThreads = std::strtoul(Next,nullptr,10);
+		else if (Arg == "--set-threads" && Next) SetThreads = std::strtoul(Next,nullptr,10);
+		else if (Arg == "--lookups" && Next) Lookups = std::strtoull(Next,nullptr,10);
+		else if (Arg == "--repeat" && Next) Repeat = std::max(1ul,std::strtoul(Next,nullptr,10));
+		else if (Arg == "--seed" && Next) O.Seed = std::strtoul(Next,nullptr,10);
+		else if (Arg == "--dir" && Next) O.Dir = Next;
+		else if (Arg == "--generate") {GenerateOnly = true; Used = false;}
+		else {Usage(); return Arg == "--help" ? 0 : 1;}
+		if (Used) i++;
+	}
+
+	DeckInfo Info = GenerateDeck(O);
+	std::printf("Deck %s: %zu values, %zu lines, %.2f MB, %u include level(s)\n",
+		Info.Top.c_str(),O.Keys,Info.Lines,Info.Bytes / 1e6,O.IncludeDepth);
+	if (GenerateOnly)
+		return 0;
+
+	Run("ReadConfig(const char*)",Info,Repeat,[&](ParseLi::Dict &D) {
+		return ParseLi::ReadConfig(Info.Top.c_str(),&D);
+	});
+	Run("ReadConfig(std::istream&)",Info,Repeat,[&](ParseLi::Dict &D) {
+		std::ifstream f_in(Info.Top);
+		return ParseLi::ReadConfig(f_in,&D);
+	});
+	if (Threads > 0) {
+		ParseLi::ReadOptions Options;
+		Options.IncludeThreads = Threads;
+		std::string Label = "ReadConfig(const char*, " + std::to_string(Threads) + " thr)";
+		Run(Label.c_str(),Info,Repeat,[&](ParseLi::Dict &D) {
+			return ParseLi::ReadConfig(Info.Top.c_str(),&D,Options);
+		});
+		Options.IoUring = false;
+		Label = "ReadConfig(const char*, " + std::to_string(Threads) + " thr, no ring)";
+		Run(Label.c_str(),Info,Repeat,[&](ParseLi::Dict &D) {
+			return ParseLi::ReadConfig(Info.Top.c_str(),&D,Options);
+		});
+	}
+	if (ParseThreads > 0) {
+		ParseLi::ReadOptions Options;
+		Options.ParseThreads = ParseThreads;
+		std::string Label = "ReadConfig(const char*, " + std::to_string(ParseThreads) + " chunk thr)";
+		Run(Label.c_str(),Info,Repeat,[&](ParseLi::Dict &D) {
+			return ParseLi::ReadConfig(Info.Top.c_str(),&D,Options);
+		});
+		Label = "ReadConfig(std::istream&, " + std::to_string(ParseThreads) + " chunk thr)";
+		Run(Label.c_str(),Info,Repeat,[&](ParseLi::Dict &D) {
+			std::ifstream f_in(Info.Top);
+			return ParseLi::ReadConfig(f_in,&D,Options);
+		});
+	}
+	if (SetThreads > 0) {
+		std::size_t Updates = std::max<std::size_t>(1,O.Keys * 5 / SetThreads);
+		ParseLi::Dict D;
+		RunUpdates("Dict::set/GetDouble",D,SetThreads,Updates);
+		ParseLi::ConcurrentDict C;
+		RunUpdates("ConcurrentDict::set/GetDouble",C,SetThreads,Updates);
+	}
+	if (Lookups > 0) {
+		ParseLi::Dict D;
+		ParseLi::ReadConfig(Info.Top.c_str(),&D);
+		std::vector<ParseLi::DictEntry> Keys = D.Prefix("KEY_");
+		if (!Keys.empty()) {
+			RunDictLookups("Dict::TryGet...",D,Keys,Lookups,0);
+			RunDictLookups("Dict::GetMany (batches of 64)",D,Keys,Lookups,64);
+			RunLookups("FrozenDict::TryGet... (table)",*D.Freeze(),Keys,Lookups);
+			RunLookups("FrozenDict::TryGet... (perfect hash)",*D.Freeze(true),Keys,Lookups);
+		}
+	}
+	return 0;
+}
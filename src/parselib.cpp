@@ -31,6 +31,66 @@
 
 #include "parselib.hpp" //Dict
 
+#include <algorithm> //std::max, std::sort
+#include <charconv> //std::from_chars
+#include <chrono>
+#include <cerrno>
+#include <cstddef> //offsetof
+#include <condition_variable>
+#include <cstdio> //std::rename, std::remove
+#include <cstring> //std::memcpy, std::memcmp
+#include <deque>
+#include <functional> //std::function
+#include <future> //std::promise
+#include <iterator> //std::istreambuf_iterator
+#include <limits>
+#include <thread>
+#include <tuple> //std::tuple
+#include <map> //std::map
+#include <new> //std::align_val_t
+#include <random> //std::random_device
+#include <sstream> //std::ostringstream
+#include <unordered_map> //std::unordered_map
+#include <unordered_set> //std::unordered_set
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PARSELI_HAVE_MMAP 1
+#include <fcntl.h> //open
+#include <sys/mman.h> //mmap, munmap, madvise
+#include <sys/stat.h> //fstat
+#include <unistd.h> //close
+#endif
+
+#if defined(__linux__)
+#define PARSELI_HAVE_INOTIFY 1
+#include <poll.h> //poll
+#include <sys/inotify.h> //inotify_init1, inotify_add_watch
+#endif
+
+#if defined(__linux__) && defined(__GNUC__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h> //io_uring_params, io_uring_sqe, io_uring_cqe
+#include <sys/syscall.h> //__NR_io_uring_setup, __NR_io_uring_enter
+#include <sys/sysmacros.h> //makedev
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_EXT_ARG) //Timed waits; IORING_OP_OPENAT and IORING_OP_READ came before
+#define PARSELI_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PARSELI_HAVE_X86_SIMD 1
+#include <immintrin.h> //SSE2, AVX2 intrinsics
+#endif
+
+//Keeps rarely taken code (e.g. counting statistics) from being inlined into hot paths
+#if defined(__GNUC__)
+#define PARSELI_COLD __attribute__((noinline,cold))
+#else
+#define PARSELI_COLD
+#endif
+
 namespace ParseLi {
 
 /**
@@ -54,439 +114,4896 @@ bool StringsEqualIgnoreCase(std::string const &S1, std::string const &S2)
 	return true;
 }
 
-inline namespace V_0_0_4 {
+inline namespace V_0_0_5 {
 /**
- * @param key Lookup value corresponding to `val`
- * @param val Value added with key `key`
- * @return `True` if successful, `False` otherwise
-*/
-bool Dict::add(std::string const &Key, double value)
+ * @param filename Name of the file to map
+ * @param type ValueType::IntArray or ValueType::DoubleArray
+ * @return `True` if the file could be mapped (or read); its size must be a
+ * 	whole number of values
+ */
+bool MappedArray::Open(const char* filename, ValueType type)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	return DoubleMap.emplace(Key,value).second;
+	if (type != ValueType::IntArray && type != ValueType::DoubleArray)
+		return false;
+	std::size_t Width = (type == ValueType::IntArray) ? sizeof(int) : sizeof(double);
+#ifdef PARSELI_HAVE_MMAP
+	int fd = open(filename,O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd,&st) != 0 || !S_ISREG(st.st_mode) || static_cast<std::size_t>(st.st_size) % Width != 0) {
+		close(fd);
+		return false;
+	}
+	std::size_t Size = static_cast<std::size_t>(st.st_size);
+	std::shared_ptr<const char> Map;
+	if (Size > 0) {
+		//Shared so that every process mapping the file uses the same page cache pages
+		void* p = mmap(nullptr,Size,PROT_READ,MAP_SHARED,fd,0);
+		if (p == MAP_FAILED) {
+			close(fd);
+			return false;
+		}
+		Map = std::shared_ptr<const char>(static_cast<const char*>(p),[Size](const char* q) {munmap(const_cast<char*>(q),Size);});
+	}
+	close(fd);
+	Device = static_cast<std::uint64_t>(st.st_dev);
+	Inode = static_cast<std::uint64_t>(st.st_ino);
+#ifdef __APPLE__
+	MTime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	MTime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#else
+	std::ifstream f_in(filename,std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+	if (!f_in) return false;
+	std::size_t Size = static_cast<std::size_t>(f_in.tellg());
+	if (Size % Width != 0)
+		return false;
+	std::shared_ptr<char> Copy(new char[Size ? Size : 1],std::default_delete<char[]>());
+	f_in.seekg(0);
+	if (!f_in.read(Copy.get(),static_cast<std::streamsize>(Size)))
+		return false;
+	std::shared_ptr<const char> Map = std::move(Copy);
+	Device = Inode = 0;
+	MTime = 0;
+#endif
+	Data = std::move(Map);
+	Bytes = Size;
+	Type = type;
+	return true;
 }
 
-//integer overload for Dict::add
-bool Dict::add(std::string const &Key, int value)
+/**
+ * @param key Key to hash
+ * @return Hash of `key`; only the key text is hashed so that entries of
+ * 	every type for the same key share a probe sequence
+ */
+std::size_t ValueTable::HashKey(std::string_view key)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	return IntMap.emplace(Key,value).second;
+	return std::hash<std::string_view>{}(key);
 }
 
-//std::string overload for Dict::add
-bool Dict::add(std::string const &Key, std::string const &value)
+/**
+ * @param key Key to look up
+ * @param hash Hash of `key` (from HashKey())
+ * @param type Type of the value being looked up
+ * @return Index of the slot holding `key`, or `npos` if it is not present
+ */
+std::size_t ValueTable::Find(std::string_view key, std::size_t hash, ValueType type) const
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	return StringMap.emplace(Key,value).second;
+	if (Slots.empty())
+		return npos;
+	std::size_t mask = Slots.size() - 1;
+	for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+		Slot const &S = Slots[i];
+		if (S.Empty())
+			return npos;
+		if (S.Hash == hash && S.Type() == type && View(S.Key) == key)
+			return i;
+	}
 }
 
 /**
- * @param key Lookup value corresponding to `val`
- * @param val Value set with key `key`
-*/
-void Dict::set(std::string const &Key, double value)
+ * @param key Key to insert
+ * @param hash Hash of `key` (from HashKey())
+ * @param type Type of the value being inserted
+ * @return Index of the slot for `key`, and `true` if the slot was created
+ * 	(holding a default-constructed value of type `type`) or `false` if
+ * 	`key` already existed with this type
+ * @note Indices are invalidated when the table grows.
+ */
+std::pair<std::size_t,bool> ValueTable::Emplace(std::string_view key, std::size_t hash, ValueType type)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	DoubleMap[Key] = value;
+	//Keep the load factor below 0.7 so probe sequences stay short
+	if ((Count + 1) * 10 > Slots.size() * 7)
+		Rehash(Slots.empty() ? 16 : Slots.size() * 2);
+
+	std::size_t mask = Slots.size() - 1;
+	std::size_t i = hash & mask;
+	for (; !Slots[i].Empty(); i = (i + 1) & mask) {
+		Slot const &S = Slots[i];
+		if (S.Hash == hash && S.Type() == type && View(S.Key) == key)
+			return {i,false};
+	}
+
+	Slot S;
+	S.Hash = hash;
+	S.Key = Intern(key,hash);
+	S.Tag = static_cast<unsigned char>(type);
+	switch (type) {
+		case ValueType::Int: S.Int = 0; break;
+		case ValueType::Double: S.Double = 0.0; break;
+		case ValueType::String:
+		case ValueType::IntArray:
+		case ValueType::DoubleArray: S.Str = StringRef(); break;
+	}
+	CopySlot(Mutable(i),S);
+	Count++;
+	TypeCount[static_cast<std::size_t>(type)]++;
+	return {i,true};
 }
 
-//integer overload for Dict::set
-void Dict::set(std::string const &Key, int value)
+/**
+ * @param i Index of an occupied slot
+ * @note Following entries of the probe sequence are shifted back into the
+ * 	gap, so lookups never need tombstones.
+ */
+void ValueTable::Erase(std::size_t i)
+{
+	Count--;
+	TypeCount[static_cast<std::size_t>(Slots[i].Type())]--;
+	std::size_t mask = Slots.size() - 1;
+	for (std::size_t j = (i + 1) & mask; !Slots[j].Empty(); j = (j + 1) & mask) {
+		//Move entry j into the gap unless its home slot lies between the gap and j
+		std::size_t home = Slots[j].Hash & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			CopySlot(Mutable(i),Slots[j]);
+			i = j;
+		}
+	}
+	CopySlot(Mutable(i),Slot());
+}
+
+/**
+ * @param s String to store
+ * @param hash Hash of `s` (from HashKey())
+ * @return Reference to the only copy of `s` in the arena
+ * @throw std::length_error if the arena would exceed 4 GiB
+ */
+ValueTable::StringRef ValueTable::Intern(std::string_view s, std::size_t hash)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	IntMap[Key] = value;
+	if (s.empty())
+		return StringRef();
+	if ((InternCount + 1) * 10 > Interned.size() * 7)
+		RehashInterned(Interned.empty() ? 16 : Interned.size() * 2);
+
+	std::size_t mask = Interned.size() - 1;
+	std::size_t i = hash & mask;
+	for (; Interned[i].Ref.Length != 0; i = (i + 1) & mask)
+		if (Interned[i].Hash == hash && View(Interned[i].Ref) == s)
+			return Interned[i].Ref;
+
+	StringRef R = Append(s);
+	Interned.Mutable(i,nullptr) = InternSlot{hash,R};
+	InternCount++;
+	return R;
 }
 
-//std::string overload for Dict::set
-void Dict::set(std::string const &Key, std::string const &value)
+/** @brief Allocates an arena block aligned for arrays */
+static std::shared_ptr<char> AllocateBlock(std::size_t Bytes, std::size_t Align)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	StringMap[Key] = value;
+	return std::shared_ptr<char>(static_cast<char*>(::operator new[](Bytes,std::align_val_t(Align))),
+		[Align](char* p) {::operator delete[](p,std::align_val_t(Align));});
 }
 
 /**
- * @param key Lookup value corresponding to `val`
- * @param val Value set with key `key`
-*/
-void Dict::try_set(std::string const &Key, double value)
+ * @param s Bytes to copy (may themselves live in the arena, since existing
+ * 	pages never move)
+ * @param Align Alignment of the copy (a power of two no larger than ArrayAlign)
+ * @return Reference to the copy
+ * @throw std::length_error if the arena would exceed 4 GiB
+ *
+ * Data is packed into the last page while it fits.  Data that does not fit
+ * starts a new block, which spans as many pages as it needs.
+ */
+ValueTable::StringRef ValueTable::Append(std::string_view s, std::size_t Align)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	if (!CheckDouble(Key))
-		DoubleMap[Key] = value;
+	std::size_t Used = ArenaSize & (PageSize - 1);
+	std::size_t Room = Used ? PageSize - Used : 0;
+	std::size_t Pad = (Align - (ArenaSize & (Align - 1))) & (Align - 1);
+	bool Fits = Used != 0 && Pad + s.length() <= Room;
+	std::size_t Start = Fits ? ArenaSize + Pad : ArenaSize + Room;
+	if (Start + s.length() > std::numeric_limits<std::uint32_t>::max())
+		throw std::length_error("ValueTable: string storage exceeds 4 GiB");
+
+	if (!Pages)
+		Pages = std::make_shared<std::vector<Page>>();
+	else if (Pages.use_count() > 1)
+		Pages = std::make_shared<std::vector<Page>>(*Pages);
+
+	char* Dest;
+	if (Fits) {
+		Page &P = (*Pages)[ArenaSize >> PageShift];
+		if (P.Block.use_count() > 1) {
+			std::shared_ptr<char> Copy = AllocateBlock(PageSize,ArrayAlign);
+			std::memcpy(Copy.get(),P.Block.get(),Used);
+			//Arrays handed out as spans may live in the old page
+			RetiredPages.push_back(std::move(P.Block));
+			P.Block = std::move(Copy);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		Dest = P.Block.get() + (Start - P.Base);
+		ArenaSize = Start + s.length();
+	} else {
+		std::size_t Extent = std::max<std::size_t>(1,(s.length() + PageSize - 1) >> PageShift);
+		std::shared_ptr<char> Block = AllocateBlock(Extent << PageShift,ArrayAlign);
+		for (std::size_t p = 0; p < Extent; p++)
+			Pages->push_back(Page{Block,static_cast<std::uint32_t>(Start)});
+		Dest = Block.get();
+		//Only single pages are appended to, so a copy never has to split a block
+		ArenaSize = (Extent > 1) ? Start + (Extent << PageShift) : Start + s.length();
+	}
+	std::memcpy(Dest,s.data(),s.length());
+	return StringRef{static_cast<std::uint32_t>(Start),static_cast<std::uint32_t>(s.length())};
 }
 
-//integer overload for Dict::try_set
-void Dict::try_set(std::string const &Key, int value)
+/**
+ * @param NewCapacity New size of the interning index (must be a power of two)
+ */
+void ValueTable::RehashInterned(std::size_t NewCapacity)
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	if (!CheckInt(Key))
-		IntMap[Key] = value;
+	Chunked<InternSlot> Next(NewCapacity);
+	std::size_t mask = Next.size() - 1;
+	for (std::size_t j = 0; j < Interned.size(); j++) {
+		InternSlot const &E = Interned[j];
+		if (E.Ref.Length == 0)
+			continue;
+		std::size_t i = E.Hash & mask;
+		while (Next[i].Ref.Length != 0)
+			i = (i + 1) & mask;
+		Next.Unshared(i) = E;
+	}
+	Interned = std::move(Next);
 }
 
-//std::string overload for Dict::try_set
-void Dict::try_set(std::string const &Key, std::string const &value)
+/**
+ * @param S Slot to read
+ * @return Copy of the value held by `S`
+ */
+ValueTable::Value ValueTable::Get(Slot const &S) const
 {
-	std::lock_guard<std::mutex> lock(DictMutex);
-	if (!CheckString(Key))
-		StringMap[Key] = value;
+	switch (S.Type()) {
+		case ValueType::Int: return S.Int;
+		case ValueType::Double: return S.Double;
+		case ValueType::String: return std::string(StringOf(S));
+		case ValueType::IntArray: {
+			Span<const int> v = IntsOf(S);
+			return std::vector<int>(v.begin(),v.end());
+		}
+		case ValueType::DoubleArray: {
+			Span<const double> v = DoublesOf(S);
+			return std::vector<double>(v.begin(),v.end());
+		}
+	}
+	return Value();
 }
 
 /**
- * @param key Value to look up
- * @return Value corresponding to `key`
- * @throw std::out_of_range if value cannot be found
-*/
-double Dict::GetDouble(std::string const &key) const
+ * @param S Slot to read
+ * @return View of the value held by `S`, into the arena or a mapped file
+ */
+ValueTable::ValueView ValueTable::ViewOf(Slot const &S) const
 {
-	double ret;
-	try {
-		std::lock_guard<std::mutex> lock(DictMutex);
-		ret = DoubleMap.at(key);
-	} catch (const std::out_of_range& e){
-		std::cerr << "Value \"" << key << "\" out of range of doubles map (maybe this isn't a double?)" << std::endl;
-		throw;
+	switch (S.Type()) {
+		case ValueType::Int: return S.Int;
+		case ValueType::Double: return S.Double;
+		case ValueType::String: return StringOf(S);
+		case ValueType::IntArray: return IntsOf(S);
+		case ValueType::DoubleArray: return DoublesOf(S);
 	}
-	return ret;
+	return ValueView();
 }
 
 /**
- * @param key Value to look up
- * @return Value corresponding to `key`
- * @throw std::out_of_range if value cannot be found
-*/
-int Dict::GetInt(std::string const &key) const
+ * @param S Slot to write
+ * @param val Value to store; ignored unless it has the type of `S`
+ */
+void ValueTable::Set(Slot &S, Value const &val)
 {
-	int ret;
-	try {
-		std::lock_guard<std::mutex> lock(DictMutex);
-		ret = IntMap.at(key);
-	} catch (const std::out_of_range& e) {
-		std::cerr << "Value \"" << key << "\" out of range of int map (maybe this isn't a int?)" << std::endl;
-		throw;
+	if (val.index() != S.Tag)
+		return;
+	switch (S.Type()) {
+		case ValueType::Int: Set(S,std::get<int>(val)); break;
+		case ValueType::Double: Set(S,std::get<double>(val)); break;
+		case ValueType::String: Set(S,std::string_view(std::get<std::string>(val))); break;
+		case ValueType::IntArray: Set(S,Span<const int>(std::get<std::vector<int>>(val))); break;
+		case ValueType::DoubleArray: Set(S,Span<const double>(std::get<std::vector<double>>(val))); break;
 	}
-	return ret;
 }
 
 /**
- * @param key Value to look up
- * @return Value corresponding to `key`
- * @throw std::out_of_range if value cannot be found
-*/
-std::string Dict::GetString(std::string const &key) const
+ * @param S Slot to write
+ * @param T Table holding `From`
+ * @param From Slot whose value is stored (a mapped array stays mapped)
+ */
+void ValueTable::Set(Slot &S, ValueTable const &T, Slot const &From)
 {
-	std::string ret;
-	try {
-		std::lock_guard<std::mutex> lock(DictMutex);
-		ret = StringMap.at(key);
-	} catch (const std::out_of_range& e){
-		std::cerr << "Value \"" << key << "\" out of range of string map (maybe this isn't a string?)" << std::endl;
-		throw;
+	if (MappedArray const* M = T.MappingOf(From)) {
+		Set(S,*M);
+		return;
+	}
+	switch (From.Type()) {
+		case ValueType::Int: Set(S,From.Int); break;
+		case ValueType::Double: Set(S,From.Double); break;
+		case ValueType::String: Set(S,T.StringOf(From)); break;
+		case ValueType::IntArray: Set(S,T.IntsOf(From)); break;
+		case ValueType::DoubleArray: Set(S,T.DoublesOf(From)); break;
 	}
-	return ret;
 }
 
-/** @brief Checks if a string contains the word 'true' or 'false'
- * @param value    Value to test
- * @returns true if value is 'true'
- * @returns false if value is 'false'
- * @throws std::runtime_error if value is not 'true' or 'false'
+/**
+ * @param S Slot to write (of the type of `val`)
+ * @param val Mapped file to refer to; the table keeps it mapped
  */
-static bool CheckIfStringTrueOrFalse(const std::string &value)
+void ValueTable::Set(Slot &S, MappedArray const &val)
 {
-	if (value.length() == 4) {
-		if (std::tolower(value[0]) == 't' &&
-		    std::tolower(value[1]) == 'r' &&
-		    std::tolower(value[2]) == 'u' &&
-		    std::tolower(value[3]) == 'e') return true;
-	} else if (value.length() == 5) {
-		if (std::tolower(value[0]) == 'f' &&
-		    std::tolower(value[1]) == 'a' &&
-		    std::tolower(value[2]) == 'l' &&
-		    std::tolower(value[3]) == 's' &&
-		    std::tolower(value[4]) == 'e') return false;
+	if (!Mappings)
+		Mappings = std::make_shared<std::vector<MappedArray>>();
+	else if (Mappings.use_count() > 1)
+		Mappings = std::make_shared<std::vector<MappedArray>>(*Mappings);
+	Mappings->push_back(val);
+	S.Mapped = true;
+	StoreShared(S.Str,StringRef{static_cast<std::uint32_t>(Mappings->size() - 1),0});
+}
+
+/**
+ * @return Bytes held by the slot array, the arena and the interning index,
+ * 	including those shared with copies of the table
+ */
+MemoryStats ValueTable::Memory() const
+{
+	MemoryStats M;
+	M.Entries = Count;
+	M.SlotBytes = Slots.size() * sizeof(Slot) + RetiredBytes;
+	M.InternBytes = Interned.size() * sizeof(InternSlot);
+	M.Strings = InternCount;
+	M.SharedBytes = Slots.SharedBytes() + Interned.SharedBytes();
+	if (Pages) {
+		M.ArenaBytes = (Pages->size() + RetiredPages.size()) * PageSize;
+		M.ArenaUsed = ArenaSize;
+		//A block spanning n pages is referenced n times by this table alone
+		for (std::size_t p = 0; p < Pages->size(); ) {
+			std::size_t n = 1;
+			while (p + n < Pages->size() && (*Pages)[p + n].Block == (*Pages)[p].Block)
+				n++;
+			if (Pages.use_count() > 1 || (*Pages)[p].Block.use_count() > static_cast<long>(n))
+				M.SharedBytes += n * PageSize;
+			p += n;
+		}
 	}
-	throw std::runtime_error("Unable to convert string to bool");
+	if (Mappings)
+		for (MappedArray const &A : *Mappings)
+			M.MappedBytes += A.MappedBytes();
+	return M;
 }
 
 /**
- * @param key Value to look up
- * @return true if string at `key` is "true"
- * @return false if string at `key` is "false"
- * @throw std::out_of_range if value cannot be found
- * @throw std::runtime_error if value is neither true or false
+ * @return A table with the values of this one in a freshly built arena
+ * @note Mapped arrays are referred to, not copied.
  */
-bool Dict::GetBool(std::string const &key) const
+ValueTable ValueTable::Compacted() const
 {
-	bool ret;
-	try {
-		std::lock_guard<std::mutex> lock(DictMutex);
-		ret = CheckIfStringTrueOrFalse(StringMap.at(key));
-	} catch (const std::out_of_range& e) {
-		std::cerr << "Value \"" << key << "\" out of range of string map (maybe this isn't a string?)" << std::endl;
-		throw;
+	ValueTable T;
+	for (std::size_t i = 0; i < Slots.size(); i++) {
+		Slot const &S = Slots[i];
+		if (!S.Empty())
+			T.Set(T.Mutable(T.Emplace(KeyOf(S),S.Hash,S.Type()).first),*this,S);
 	}
-	return ret;
+	return T;
 }
 
 /**
- * @param key Value to look up
- * @return `True` if `key` exists, `False` otherwise
-*/
-bool Dict::CheckDouble(std::string const &key) const
+ * @param NewCapacity New number of slots (must be a power of two)
+ */
+void ValueTable::Rehash(std::size_t NewCapacity)
 {
-	if (DoubleMap.find(key) == DoubleMap.end())
-		return false;
-	return true;
+	Chunked<Slot> Next(NewCapacity);
+	std::size_t mask = Next.size() - 1;
+	for (std::size_t j = 0; j < Slots.size(); j++) {
+		Slot const &S = Slots[j];
+		if (S.Empty())
+			continue;
+		std::size_t i = S.Hash & mask;
+		while (!Next[i].Empty())
+			i = (i + 1) & mask;
+		Next.Unshared(i) = S;
+	}
+	RetireSlots();
+	Slots = std::move(Next);
+}
+
+void ValueTable::RetireSlots()
+{
+	if (!Retain)
+		return;
+	for (std::shared_ptr<Slot> const &C : Slots.Chunks()) {
+		Retired.push_back(C);
+		RetiredBytes += Slots.ChunkSize() * sizeof(Slot);
+	}
 }
 
 /**
- * @param key Value to look up
- * @return `True` if `key` exists, `False` otherwise
-*/
-bool Dict::CheckInt(std::string const &key) const
+ * @param T Table to copy
+ * @return Reference to this table
+ * @note The chunks of `T` are shared rather than copied.
+ */
+ValueTable& ValueTable::operator=(const ValueTable &T)
 {
-	if (IntMap.find(key) == IntMap.end())
-		return false;
-	return true;
+	if (this != &T) {
+		RetireSlots();
+		Slots = T.Slots;
+		Count = T.Count;
+		for (std::size_t i = 0; i < 6; i++)
+			TypeCount[i] = T.TypeCount[i];
+		Pages = T.Pages;
+		ArenaSize = T.ArenaSize;
+		Interned = T.Interned;
+		InternCount = T.InternCount;
+		Mappings = T.Mappings;
+	}
+	return *this;
 }
 
 /**
- * @param key Value to look up
- * @return `True` if `key` exists, `False` otherwise
-*/
-bool Dict::CheckString(std::string const &key) const
+ * @param T Table to take the values of
+ * @return Reference to this table
+ * @note Unlike the values, the retained slot chunks are not taken from `T`,
+ * 	so that readers of this table are still protected.
+ */
+ValueTable& ValueTable::operator=(ValueTable &&T)
 {
-	if (StringMap.find(key) == StringMap.end())
-		return false;
-	return true;
+	if (this != &T) {
+		RetireSlots();
+		Slots = std::move(T.Slots);
+		Count = T.Count;
+		for (std::size_t i = 0; i < 6; i++)
+			TypeCount[i] = T.TypeCount[i];
+		Pages = std::move(T.Pages);
+		ArenaSize = T.ArenaSize;
+		Interned = std::move(T.Interned);
+		InternCount = T.InternCount;
+		Mappings = std::move(T.Mappings);
+	}
+	return *this;
 }
 
-//Printout all values from the dictionary
-void Dict::Dump() const
+/*
+	Diagnostics
+
+	Messages go to the sink set for the current read (ReadOptions::
+	Diagnostics), or else to the global one.  Diagnose() only builds a
+	record if the sink wants its level.
+*/
+
+/** @brief The global sink (never destroyed, so that messages can be reported from static destructors)
+ *
+ * Records below Severity::Warning are only reported by reads with `Debug`
+ * set, so by default warnings and errors are printed, and debug output
+ * only when it was asked for.
+ */
+static std::shared_ptr<DiagnosticSink>& GlobalDiagnostics()
 {
-	using std::cout, std::endl, std::setw;
-	std::lock_guard<std::mutex> lock(DictMutex);
-	cout << "Dictionary Dump" << endl << endl << "+->Integer Database" << endl;
-	//Dump Integers
-	cout << "+--->Size: " << IntMap.size() << endl;
-	cout << "+---># of Buckets: " << IntMap.bucket_count() << endl;
-	cout << "+--->Load Factor: " << IntMap.load_factor() << endl;
-	for (auto i : IntMap)// = IntMap.begin(); i != IntMap.end(); ++i)
-		cout << setw(20) << std::left << i.first << ": " << i.second << endl;
+	static std::shared_ptr<DiagnosticSink>* Sink = new std::shared_ptr<DiagnosticSink>(std::make_shared<StreamDiagnostics>());
+	return *Sink;
+}
 
-	//Dump Floats
-	cout << "+--->Size: " << DoubleMap.size() << endl;
-	cout << "+---># of Buckets: " << DoubleMap.bucket_count() << endl;
-	cout << "+--->Load Factor: " << DoubleMap.load_factor() << endl;
-	for (auto i : DoubleMap)// = DoubleMap.begin(); i != DoubleMap.end(); ++i)
-		cout << setw(20) << std::left << i.first << ": " << i.second << endl;
+/** @brief Sink of the read running on this thread, if it has one */
+static thread_local DiagnosticSink* ReadDiagnostics = nullptr;
 
-	//Dump Strings
-	cout << "+--->Size: " << StringMap.size() << endl;
-	cout << "+---># of Buckets: " << StringMap.bucket_count() << endl;
-	cout << "+--->Load Factor: " << StringMap.load_factor() << endl;
-	for (auto i : StringMap)// = StringMap.begin(); i != StringMap.end(); ++i)
-		cout << setw(20) << std::left << i.first << ": " << i.second << endl;
+/**
+ * @param Sink Receiver of all messages, or `nullptr` to discard them
+ * @return The sink it replaces
+ */
+std::shared_ptr<DiagnosticSink> SetDiagnostics(std::shared_ptr<DiagnosticSink> Sink)
+{
+	return std::atomic_exchange_explicit(&GlobalDiagnostics(),std::move(Sink),std::memory_order_acq_rel);
 }
 
 /**
- * @brief Skips whitespace in a std::string and increments a position indicator accordingly
- * @param LineData      Line data being parsed
- * @param siter         Current string iterator position (incremented to skip whitespace)
- * @returns `true` if whitespace is skipped and input is ready to be parsed
- * @returns `false` if a comment indicator or null character is encountered
+ * @return The sink receiving messages outside reads with their own sink (may be null)
  */
-static bool SkipStringWhitespace(std::string const &LineData, int &siter)
+std::shared_ptr<DiagnosticSink> GetDiagnostics()
 {
-	while ((LineData[siter] == ' ' || LineData[siter] == '\t') && LineData[siter] != '\0' && LineData[siter] != '#')
-		siter++;
-	if (LineData[siter] == '\0' || LineData[siter] == '#')
-		return false;
-	return true;
+	return std::atomic_load_explicit(&GlobalDiagnostics(),std::memory_order_acquire);
 }
 
 /**
- * @brief Reads a word from a std::string and increments a position indicator accordingly (terminates on whitespace)
- * @param LineData      Line data being parsed
- * @param siter         Current string iterator position (incremented to end of word)
- * @returns std::string containing the value read (excluding whitespace characters)
+ * @brief Reports a message to the current sink, if it wants its level
+ * @param Level         Severity of the message
+ * @param File          Input file concerned (may be empty)
+ * @param Line          Line of `File` (0 if unknown)
+ * @param Key           Key concerned (may be empty)
+ * @param Message       Called to build the message (only if it is wanted)
  */
-static std::string ReadValue(std::string const &LineData, int& siter)
+template <class F>
+static void Diagnose(Severity Level, std::string_view File, int Line, std::string_view Key, F &&Message)
 {
-	std::string Value;
-	while (LineData[siter] != '\n' && LineData[siter] != '\t' && LineData[siter] != '#' && LineData[siter] != '\0' && LineData[siter] != ' ') {
-		Value += LineData[siter];
-		siter++;
+	std::shared_ptr<DiagnosticSink> Global;
+	DiagnosticSink* Sink = ReadDiagnostics;
+	if (!Sink) {
+		Global = GetDiagnostics();
+		Sink = Global.get();
 	}
-	return Value;
-}
-
-/**
- * @brief Parses a std::string to determine what type of information is contained (string, int, or float)
- * @param ValCheck      Vector of 3 bools indicating if (0) contains numbers, (1) contains a decimal point, (2) contains other characters that are non-numeric
- * @param VarVal        String being tested
- */
-static void GetValueType(bool* ValCheck, std::string const &VarVal)
-{
-	bool ExpForm = false; //Whether string is already categorized as being in exponential form
-	ValCheck[0] = false; //Contains numbers
-	ValCheck[1] = false; //Contains decimal point
-	ValCheck[2] = false; //Contains string data
-	for (unsigned int i{0}; i < VarVal.length(); i++) {
-		if (VarVal[i] != ' ') {
-			if (!ValCheck[0] && ((VarVal[i] >= '0' && VarVal[i] <= '9') || VarVal[i] == '-'))
-				ValCheck[0] = true; //Contains integers;
-			else if (!ValCheck[1] && VarVal[i] == '.')
-				ValCheck[1] = true; //Contains decimal
-			else if ((!ValCheck[2] && !((VarVal[i] >= '0' && VarVal[i] <= '9') || VarVal[i] == '-' || VarVal[i] == '+' || VarVal[i] == '.')) || ((VarVal[i] == '.' && ValCheck[1]))) {
-				if (VarVal[i] == 'e' || VarVal[i] == 'E') { //Contains exponent
-					if (ExpForm) {
-						ValCheck[2] = true;
-						break; //Nothing can override a string;  Break if this happens.
-					} else {
-						ValCheck[1] = true;
-						ExpForm = true;
-					}
-				} else {
-					ValCheck[2] = true;
-					break; //Nothing can override a string;  Break if this happens.
-				}
-			}
-		}
+	if (Sink && Sink->Wants(Level))
+		Sink->Report(Diagnostic{Level,std::string(File),Line,std::string(Key),Message()});
+}
+
+/** @brief Ends a batch of messages on the current sink */
+static void FlushDiagnostics()
+{
+	if (ReadDiagnostics) {
+		ReadDiagnostics->Flush();
+	} else if (std::shared_ptr<DiagnosticSink> Global = GetDiagnostics()) {
+		Global->Flush();
 	}
 }
 
-/**
- * @brief Stores a value given by VarVal in the dictionary with key VarName
- * @param D             Dictionary object being manipulated
- * @param VarName       Variable name being added to dictionary
- * @param VarVal        Value being added (as std::string; this will be parsed internally)
- * @param ln            Line number (for error handling)
- * @param Buffer        Character array containing line data (for error handling)
- * @param Debug         Error handling flag
- * @returns `true` on successful addition of a value to the dictionary.
- * @returns `false` if a value was not able to be added to the dictionary.
+/** @class DiagnosticsScope
+ * @brief Sends this thread's messages to the sink of a read until the read ends, then flushes them
  */
-static bool StoreValue(Dict* D, std::string VarName, std::string const &VarVal, int ln, const char* Buffer, bool Debug = false)
+class DiagnosticsScope
 {
-	using std::cerr, std::endl;
-	bool ValCheck[3] {0,0,0}; //int, double, string;
-	GetValueType(ValCheck,VarVal);
-	if (ValCheck[2]) { //String add
-		D->add(VarName,VarVal);
-		if (Debug) cerr << "String added: " << VarName << ": " << VarVal << endl;
-	} else if (ValCheck[1]) { //(double) float add
-		try {D->add(VarName,std::stod(VarVal.c_str()));}
-		catch (const std::invalid_argument &e) {
-			cerr << "Failed to parse double " << VarVal << " on line " << ln << ":" << endl;
-			cerr << Buffer << endl;
-			return false;
-		} catch (const std::out_of_range &e) {
-			cerr << "Double " << VarVal << " on line " << ln << " is out of range." << endl;
-			return false;
-		}
-		if (Debug) cerr << "Float added: " << VarName << ": " << VarVal << endl;
-	} else if (ValCheck[0]) { //int add
-		try {D->add(VarName,std::stoi(VarVal.c_str()));}
-		catch (const std::invalid_argument &e) {
-			cerr << "Failed to parse int " << VarVal << " on line " << ln << ":" << endl;
-			cerr << Buffer << endl;
-			return false;
-		} catch (const std::out_of_range &e) {
-			cerr << "Int " << VarVal << " on line " << ln << " is out of range." << endl;
-			return false;
-		}
-		if (Debug) cerr << "Int added: " << VarName << ": " << VarVal << endl;
+	DiagnosticSink* Previous;
+	public:
+	explicit DiagnosticsScope(DiagnosticSink* Sink) : Previous(ReadDiagnostics)
+	{
+		if (Sink) ReadDiagnostics = Sink;
 	}
-	return true;
+	~DiagnosticsScope()
+	{
+		FlushDiagnostics();
+		ReadDiagnostics = Previous;
+	}
+	DiagnosticsScope(DiagnosticsScope const&) = delete;
+	DiagnosticsScope& operator=(DiagnosticsScope const&) = delete;
+};
+
+/**
+ * @brief Reports a key that a throwing getter could not find
+ * @param key Key looked up
+ * @param Map Description of the values searched
+ */
+static void ReportMissing(std::string_view key, const char* Map)
+{
+	Diagnose(Severity::Error,std::string_view(),0,key,[&]{return "Value \"" + std::string(key) + "\" out of range of " + Map;});
 }
 
 /**
- * @brief Enforces the value of a string (with some limitations)
- * @param filename      Name of file being loaded
- * @param D             Dictionary where information is loaded to
- * @param siter         Current string iterator position (incremented to end of word)
- * @param VarVal        Name of enforced variable being tested
- * @param LineData      Current line being parsed
- * @returns `true` if enforced value is satisfied (or has been added to dictionary)
- * @returns `false` if enforcement is violated by a prior definition
- */
-static bool ValueEnforcer(const char* filename, Dict* D, int &siter, std::string &VarVal, std::string &LineData) {
-	siter++;
-	std::string Enforcer = VarVal;
-	std::string EnforceVal;
-	if (D->CheckString(Enforcer)) { //If enforcing a value, check if it is identical
-		while (LineData[siter] != '\n' && LineData[siter] != '\t' && LineData[siter] != '#' && LineData[siter] != '\0' && LineData[siter] != ' ') {
-			EnforceVal += LineData[siter];
-			siter++;
-		}
-		if (EnforceVal.compare(D->GetString(Enforcer)) != 0) {
-			std::cerr << "Error enforcing " << Enforcer << " in filename " << filename; 
-			std::cerr << ": value mismatch (" << EnforceVal << " vs " << D->GetString(Enforcer) << ")" << std::endl;
-			return false;
-		}
-	} else {
-		while (LineData[siter] != '\n' && LineData[siter] != '\t' && LineData[siter] != '#' && LineData[siter] != '\0' && LineData[siter] != ' ') {
-			EnforceVal += LineData[siter];
-			siter++;
-		}
-		D->add(Enforcer,EnforceVal);
+ * @param D Record to format
+ * @return The message, marked if it is a warning
+ */
+std::string FormatDiagnostic(Diagnostic const &D)
+{
+	if (D.Level == Severity::Warning)
+		return "\x1b[1mWARNING\x1b[0m:" + D.Message;
+	return D.Message;
+}
+
+/** @brief Bytes of text StreamDiagnostics collects before writing them out */
+static constexpr std::size_t DiagnosticBufferSize = 64 * 1024;
+
+/**
+ * @param D Record to print
+ */
+void StreamDiagnostics::Report(Diagnostic const &D)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	Pending += FormatDiagnostic(D);
+	Pending += '\n';
+	//An error (e.g. a failed lookup, about to throw) is written at once
+	if (Pending.length() >= DiagnosticBufferSize || D.Level == Severity::Error) {
+		Out.write(Pending.data(),static_cast<std::streamsize>(Pending.length()));
+		if (D.Level == Severity::Error)
+			Out.flush();
+		Pending.clear();
 	}
-	return true;
+}
+
+//Writes the collected text and flushes the stream
+void StreamDiagnostics::Flush()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (Pending.empty())
+		return;
+	Out.write(Pending.data(),static_cast<std::streamsize>(Pending.length()));
+	Out.flush();
+	Pending.clear();
 }
 
 /**
- * @brief Handles a set of input data
- * @param filename      Name of file being loaded
- * @param Buffer        Raw line data buffer
- * @param ln            Line number
- * @param D             Dictionary where information is loaded to
- * @param siter         Current string iterator position (incremented to end of word)
- * @param VarName       Name of variable being handled
- * @param VarVal        Value of variable being handled
- * @param LineData      Current line being parsed
- * @param Debug         Whether to print debug info
- * @returns `true` if line data was handled successfully
- * @returns `false` if something went wrong (outputs to std::cerr)
+ * @param Level Severity of a record about to be reported
+ * @return Whether the record is wanted and there is room for it (otherwise
+ * 	it is counted as dropped without being built)
  */
-static bool ValueHandler(const char* filename, const char* Buffer, int &ln, Dict* D, int &siter, std::string &VarName, std::string &VarVal, std::string &LineData, bool Debug = false) 
+bool BufferedDiagnostics::Wants(Severity Level) const
 {
-	using std::cerr, std::endl;
-	//Include handler (THIS DOES NOT DETECT RECURSION)
-	//Recursion detection could be implemented by keeping a running tab of open files
-	if (VarName.compare("include") == 0 || VarName.compare("INCLUDE") == 0) {
-		if (VarVal.compare(filename) == 0) {
-			cerr << "Error in file include: Filename " << VarVal << " cannot include itself (line " << ln << ")" << endl;
-			return true;
-		}
-		ReadConfig(VarVal.c_str(),D,Debug);
-		return true;
-	} 
-	//Warning handler
-	if (VarName.compare("WARNING") == 0 || VarName.compare("warning") == 0) {
-		cerr << "\x1b[1mWARNING\x1b[0m:";
-		cerr << LineData.substr(LineData.find(' ')) << endl;
+	if (Level < Min)
+		return false;
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (Records.size() < Capacity)
 		return true;
+	Dropped++;
+	return false;
+}
+
+/**
+ * @param D Record to keep
+ */
+void BufferedDiagnostics::Report(Diagnostic const &D)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (Records.size() < Capacity)
+		Records.push_back(D);
+	else
+		Dropped++;
+}
+
+/**
+ * @return The records kept since the last call, oldest first
+ */
+std::vector<Diagnostic> BufferedDiagnostics::Take()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	std::vector<Diagnostic> Out;
+	Out.swap(Records);
+	return Out;
+}
+
+/**
+ * @return Records dropped because the buffer was full
+ */
+std::size_t BufferedDiagnostics::DroppedCount() const
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Dropped;
+}
+
+/**
+ * @param Out Stream to print to
+ */
+void BufferedDiagnostics::Print(std::ostream &Out) const
+{
+	std::string Text;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (Diagnostic const &D : Records) {
+			Text += FormatDiagnostic(D);
+			Text += '\n';
+		}
 	}
-	
-	//Enforcement handler (only handles strings)
-	if (VarName.compare("enforce") == 0 || VarName.compare("ENFORCE") == 0) {
-		bool EnforceSuccess = ValueEnforcer(filename, D, siter, VarVal, LineData);
-		if (EnforceSuccess)
-			return true;
-		else
-			return false;
-	}
-	//Store in dictionary
-	if (!StoreValue(D,VarName,VarVal,ln,Buffer,Debug))
-		return false;
-	
-	return true;
+	Out << Text << std::flush;
 }
 
 /**
- * @param filename      Name of the configuration file to read
- * @param D             Dictionary where information is loaded to
+ * @param D Record to pass on
+ */
+void CallbackDiagnostics::Report(Diagnostic const &D)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	Callback(D);
+}
+
+/*
+	Statistics
+
+	Every thread counts its lookups and lock waits into its own block of
+	counters, which only that thread writes, so counting takes relaxed loads
+	and stores rather than atomic read-modify-writes.  The blocks are listed
+	in a registry that GetStats() adds up; a thread's counts are moved into
+	the registry when it exits.  Per-file figures are rare enough to be
+	added to the registry directly.
+*/
+
+/** @brief Whether Stats are being gathered (see EnableStats()) */
+static std::atomic<bool> StatsOn{false};
+
+/** @brief On average, one lookup in HotKeySample is counted in the hot-key tables
+ *
+ * The lookups counted are spaced at random, so that keys looked up in a
+ * fixed cycle are not systematically over- or under-counted.
+ */
+static constexpr std::uint32_t HotKeySample = 16;
+
+/** @class HotKeyTable
+ * @brief Approximate counts of the most frequent keys ("space-saving" algorithm)
+ *
+ * Keys are kept in small sets chosen by their hash.  A new key replaces
+ * the least counted key of its set and takes over its count, so a count
+ * may be too high by at most that amount, but a key counted more often
+ * than the rest of its set is never lost.  Counting a key takes a handful
+ * of comparisons and, once the table has warmed up, no allocation.
+ */
+class HotKeyTable
+{
+	struct Entry
+	{
+		std::size_t Hash = 0;
+		std::uint64_t Count = 0; ///<0 for an unused entry
+		std::string Key;
+	};
+	static constexpr std::size_t Ways = 4;  ///<Entries per set
+	static constexpr std::size_t Sets = 64;
+	Entry Entries[Sets * Ways];
+	public:
+	/** @brief Counts `n` lookups of `key`, whose hash is `hash` */
+	void Add(std::string_view key, std::size_t hash, std::uint64_t n)
+	{
+		Entry* Set = Entries + (hash % Sets) * Ways;
+		Entry* Least = Set;
+		for (std::size_t w = 0; w < Ways; w++) {
+			Entry &E = Set[w];
+			if (E.Count && E.Hash == hash && E.Key == key) {
+				E.Count += n;
+				return;
+			}
+			if (E.Count < Least->Count)
+				Least = &E;
+		}
+		Least->Hash = hash;
+		Least->Key.assign(key.data(),key.length());
+		Least->Count += n;
+	}
+	/** @brief Counts every key of `T` */
+	void Merge(HotKeyTable const &T)
+	{
+		for (Entry const &E : T.Entries)
+			if (E.Count)
+				Add(E.Key,E.Hash,E.Count);
+	}
+	/** @brief Adds the count of every key to `Out` */
+	void AddTo(std::unordered_map<std::string,std::uint64_t> &Out) const
+	{
+		for (Entry const &E : Entries)
+			if (E.Count)
+				Out[E.Key] += E.Count;
+	}
+	void clear()
+	{
+		for (Entry &E : Entries)
+			E.Count = 0;
+	}
+};
+
+/** @brief Lookup and lock counters added up over threads */
+struct StatTotals
+{
+	std::uint64_t Hits[4][6] = {};
+	std::uint64_t Misses[4][6] = {};
+	std::uint64_t LockWaits = 0;
+	std::uint64_t LockWaitNs = 0;
+};
+
+/** @brief Counters of one thread (written only by that thread) */
+struct ThreadCounters
+{
+	std::atomic<std::uint64_t> Hits[4][6] = {};
+	std::atomic<std::uint64_t> Misses[4][6] = {};
+	std::atomic<std::uint64_t> LockWaits{0};
+	std::atomic<std::uint64_t> LockWaitNs{0};
+	std::uint32_t Countdown = 1; ///<Lookups until the next one counted in `Keys`
+	std::uint32_t Random;        ///<xorshift state drawing the next `Countdown`
+	std::mutex KeysMutex;        ///<Guards `Keys` against GetStats() and ResetStats()
+	HotKeyTable Keys;
+
+	ThreadCounters() : Random(static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(this) >> 6) | 1) {}
+
+	/** @brief Lookups until the next sample: 1 to 2 * HotKeySample - 1, HotKeySample on average */
+	std::uint32_t NextCountdown()
+	{
+		Random ^= Random << 13;
+		Random ^= Random >> 17;
+		Random ^= Random << 5;
+		return 1 + Random % (2 * HotKeySample - 1);
+	}
+
+	/** @brief Adds the counters to `T` */
+	void AddTo(StatTotals &T) const
+	{
+		for (std::size_t k = 0; k < 4; k++)
+			for (std::size_t t = 0; t < 6; t++) {
+				T.Hits[k][t] += Hits[k][t].load(std::memory_order_relaxed);
+				T.Misses[k][t] += Misses[k][t].load(std::memory_order_relaxed);
+			}
+		T.LockWaits += LockWaits.load(std::memory_order_relaxed);
+		T.LockWaitNs += LockWaitNs.load(std::memory_order_relaxed);
+	}
+};
+
+/** @brief Increments a counter written only by the calling thread */
+static inline void Bump(std::atomic<std::uint64_t> &C, std::uint64_t n = 1)
+{
+	C.store(C.load(std::memory_order_relaxed) + n,std::memory_order_relaxed);
+}
+
+/** @brief Counters of every thread, and the per-file figures */
+struct StatsRegistry
+{
+	std::mutex Mutex;
+	std::vector<ThreadCounters*> Threads; ///<Counters of running threads
+	StatTotals Exited;                    ///<Counters of threads that have exited
+	HotKeyTable ExitedKeys;
+	StatTotals Base;                      ///<Totals at the last ResetStats()
+	std::map<std::string,FileStats,std::less<>> Files;
+};
+
+/** @brief The registry (never destroyed, since threads may exit after static destructors have run) */
+static StatsRegistry& Registry()
+{
+	static StatsRegistry* R = new StatsRegistry();
+	return *R;
+}
+
+/** @class ThreadCountersOwner
+ * @brief Lists a thread's counters in the registry for as long as the thread runs
+ */
+class ThreadCountersOwner
+{
+	ThreadCounters C;
+	public:
+	ThreadCountersOwner()
+	{
+		StatsRegistry &R = Registry();
+		std::lock_guard<std::mutex> lock(R.Mutex);
+		R.Threads.push_back(&C);
+	}
+	~ThreadCountersOwner()
+	{
+		StatsRegistry &R = Registry();
+		std::lock_guard<std::mutex> lock(R.Mutex);
+		C.AddTo(R.Exited);
+		{
+			std::lock_guard<std::mutex> klock(C.KeysMutex);
+			R.ExitedKeys.Merge(C.Keys);
+		}
+		R.Threads.erase(std::find(R.Threads.begin(),R.Threads.end(),&C));
+	}
+	ThreadCountersOwner(ThreadCountersOwner const&) = delete;
+	ThreadCountersOwner& operator=(ThreadCountersOwner const&) = delete;
+	ThreadCounters& Get() {return C;}
+};
+
+/** @brief Counters of the calling thread */
+static ThreadCounters& LocalCounters()
+{
+	static thread_local ThreadCountersOwner Owner;
+	return Owner.Get();
+}
+
+#ifndef PARSELI_NO_STATS
+/** @brief Counts a lookup of `key` (only called while Stats are enabled) */
+PARSELI_COLD static void RecordLookup(std::string_view key, std::size_t hash, ValueType type, LookupKind kind, bool hit)
+{
+	ThreadCounters &C = LocalCounters();
+	std::size_t k = static_cast<std::size_t>(kind);
+	std::size_t t = static_cast<std::size_t>(type);
+	Bump(hit ? C.Hits[k][t] : C.Misses[k][t]);
+	if (--C.Countdown == 0) {
+		C.Countdown = C.NextCountdown();
+		std::lock_guard<std::mutex> lock(C.KeysMutex);
+		C.Keys.Add(key,hash,HotKeySample);
+	}
+}
+#endif
+
+/**
+ * @brief Counts a lookup in Stats, if they are enabled
+ * @param key Key looked up
+ * @param hash Hash of `key`
+ * @param type Type looked up
+ * @param kind Accessor used
+ * @param hit Whether `key` was found
+ */
+static inline void CountLookup([[maybe_unused]] std::string_view key, [[maybe_unused]] std::size_t hash, [[maybe_unused]] ValueType type, [[maybe_unused]] LookupKind kind, [[maybe_unused]] bool hit)
+{
+#ifndef PARSELI_NO_STATS
+	if (StatsOn.load(std::memory_order_relaxed))
+		RecordLookup(key,hash,type,kind,hit);
+#endif
+}
+
+/**
+ * @brief Updates the FileStats of `Name` under the registry lock
+ * @param Name Name the file was read by
+ * @param f Called with the FileStats of `Name`
+ */
+template <class F>
+static void CountFile(std::string_view Name, F &&f)
+{
+	StatsRegistry &R = Registry();
+	std::lock_guard<std::mutex> lock(R.Mutex);
+	auto it = R.Files.find(Name);
+	if (it == R.Files.end()) {
+		it = R.Files.emplace(std::string(Name),FileStats()).first;
+		it->second.Filename = it->first;
+	}
+	f(it->second);
+}
+
+/** @class StatTimer
+ * @brief Measures time for Stats (only if they were enabled when it was created)
+ */
+class StatTimer
+{
+	std::chrono::steady_clock::time_point Start;
+	bool On;
+	public:
+	StatTimer() : On(StatsEnabled())
+	{
+		if (On) Start = std::chrono::steady_clock::now();
+	}
+	/** @brief Whether the timer is running */
+	explicit operator bool() const {return On;}
+	/** @brief Seconds since the timer was created */
+	double Seconds() const {return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();}
+};
+
+/**
+ * @param on Whether to gather statistics
+ * @note Does nothing if the library was built with `PARSELI_NO_STATS`.
+ */
+void EnableStats([[maybe_unused]] bool on /*=true*/)
+{
+#ifndef PARSELI_NO_STATS
+	StatsOn.store(on,std::memory_order_relaxed);
+#endif
+}
+
+/**
+ * @return `True` if statistics are being gathered
+ */
+bool StatsEnabled()
+{
+	return StatsOn.load(std::memory_order_relaxed);
+}
+
+/**
+ * @param TopKeys Number of hot keys to return
+ * @return Counters gathered since the last call to ResetStats()
+ * @note Threads counting at the same time may be missing their latest few
+ * 	counts.
+ */
+Stats GetStats(std::size_t TopKeys /*=10*/)
+{
+	StatsRegistry &R = Registry();
+	Stats Out;
+	std::unordered_map<std::string,std::uint64_t> Keys;
+	{
+		std::lock_guard<std::mutex> lock(R.Mutex);
+		StatTotals T = R.Exited;
+		R.ExitedKeys.AddTo(Keys);
+		for (ThreadCounters* C : R.Threads) {
+			C->AddTo(T);
+			std::lock_guard<std::mutex> klock(C->KeysMutex);
+			C->Keys.AddTo(Keys);
+		}
+		for (std::size_t k = 0; k < 4; k++)
+			for (std::size_t t = 0; t < 6; t++) {
+				Out.Lookups[k][t].Hits = T.Hits[k][t] - R.Base.Hits[k][t];
+				Out.Lookups[k][t].Misses = T.Misses[k][t] - R.Base.Misses[k][t];
+			}
+		Out.LockWaits = T.LockWaits - R.Base.LockWaits;
+		Out.LockWaitSeconds = static_cast<double>(T.LockWaitNs - R.Base.LockWaitNs) * 1e-9;
+		for (auto const &[Name,F] : R.Files)
+			Out.Files.push_back(F);
+	}
+	Out.HotKeys.reserve(Keys.size());
+	for (auto &[Key,Count] : Keys)
+		Out.HotKeys.push_back({Key,Count});
+	std::sort(Out.HotKeys.begin(),Out.HotKeys.end(),[](HotKey const &A, HotKey const &B) {
+		return (A.Count != B.Count) ? A.Count > B.Count : A.Key < B.Key;
+	});
+	if (Out.HotKeys.size() > TopKeys)
+		Out.HotKeys.resize(TopKeys);
+	return Out;
+}
+
+//Sets every counter back to zero (counters are never written by other threads, so the current totals become the base)
+void ResetStats()
+{
+	StatsRegistry &R = Registry();
+	std::lock_guard<std::mutex> lock(R.Mutex);
+	StatTotals T = R.Exited;
+	R.ExitedKeys.clear();
+	for (ThreadCounters* C : R.Threads) {
+		C->AddTo(T);
+		std::lock_guard<std::mutex> klock(C->KeysMutex);
+		C->Keys.clear();
+	}
+	R.Base = T;
+	R.Files.clear();
+}
+
+/**
+ * @param kind Accessor to add up
+ * @return Hits and misses of `kind` over every type
+ */
+LookupCounts Stats::Total(LookupKind kind) const
+{
+	LookupCounts Out;
+	for (LookupCounts const &C : Lookups[static_cast<std::size_t>(kind)]) {
+		Out.Hits += C.Hits;
+		Out.Misses += C.Misses;
+	}
+	return Out;
+}
+
+/**
+ * @return Files, lookups, lock waits and hot keys, one per line
+ */
+std::string Stats::ToString() const
+{
+	static const char* const TypeNames[6] = {"", "int", "double", "string", "int array", "double array"};
+	static const char* const KindNames[4] = {"Get", "TryGet", "Check", "Handle"};
+	std::ostringstream Out;
+	Out << "Files:\n";
+	for (FileStats const &F : Files) {
+		Out << "  " << F.Filename << ": " << F.Reads << " reads, " << F.Bytes << " bytes, " << F.Lines << " lines, ";
+		Out << std::fixed << std::setprecision(3) << F.Seconds * 1e3 << " ms";
+		for (std::size_t t = 1; t < 6; t++)
+			if (F.Entries[t])
+				Out << ", " << F.Entries[t] << " " << TypeNames[t];
+		Out << "\n";
+	}
+	Out << "Lookups (hits/misses):\n";
+	for (std::size_t k = 0; k < 4; k++) {
+		LookupCounts All = Total(static_cast<LookupKind>(k));
+		if (All.Hits + All.Misses == 0)
+			continue;
+		Out << "  " << KindNames[k] << ": " << All.Hits << "/" << All.Misses;
+		for (std::size_t t = 1; t < 6; t++)
+			if (Lookups[k][t].Hits + Lookups[k][t].Misses)
+				Out << ", " << TypeNames[t] << " " << Lookups[k][t].Hits << "/" << Lookups[k][t].Misses;
+		Out << "\n";
+	}
+	Out << "Lock waits: " << LockWaits << ", " << std::fixed << std::setprecision(3) << LockWaitSeconds * 1e3 << " ms\n";
+	Out << "Hot keys (estimated lookups):\n";
+	for (HotKey const &K : HotKeys)
+		Out << "  " << K.Key << ": " << K.Count << "\n";
+	return Out.str();
+}
+
+/**
+ * @param M Mutex found held by Dict::LockScope
+ */
+void Dict::WaitFor(std::mutex &M)
+{
+	if (!StatsEnabled()) {
+		M.lock();
+		return;
+	}
+	auto Start = std::chrono::steady_clock::now();
+	M.lock();
+	auto Waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start);
+	ThreadCounters &C = LocalCounters();
+	Bump(C.LockWaits);
+	Bump(C.LockWaitNs,static_cast<std::uint64_t>(Waited.count()));
+}
+
+/**
+ * @param key Value to look up
+ * @param type Type of the value
+ * @param kind Accessor looking up the value (for Stats)
+ * @return Pointer to the slot holding `key`, or `nullptr` if not present
+ */
+ValueTable::Slot const* Dict::Lookup(std::string_view key, ValueType type, LookupKind kind) const
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	std::size_t i = Table.Find(key,hash,type);
+	CountLookup(key,hash,type,kind,i != ValueTable::npos);
+	return (i == ValueTable::npos) ? nullptr : &Table[i];
+}
+
+/**
+ * @param key Value to insert
+ * @param type Type of the value
+ * @return Pointer to the slot for `key` and `true` if it was created
+ */
+std::pair<ValueTable::Slot*,bool> Dict::Insert(std::string_view key, ValueType type)
+{
+	auto [i, inserted] = Table.Emplace(key,ValueTable::HashKey(key),type);
+	return {&Table.Mutable(i),inserted};
+}
+
+/**
+ * @param key Key to resolve
+ * @param type Type of the value
+ * @param Seen Set to the dictionary version at which `key` was resolved
+ * @param Out Set to the current value if `key` is present
+ * @param Reading Set to the counter the handle raises while it reads without the lock
+ * @return Pointer to the slot holding `key`, or `nullptr` if not present
+ */
+ValueTable::Slot const* Dict::Pin(std::string const &key, ValueType type, std::uint64_t &Seen, ValueTable::Value &Out, std::atomic<unsigned>* &Reading) const
+{
+	LockScope lock(DictMutex);
+	if (!Readers)
+		Readers = std::make_unique<ReaderCount[]>(ReaderStripes);
+	Reading = &Readers[std::hash<std::thread::id>{}(std::this_thread::get_id()) % ReaderStripes].N;
+	Table.RetainSlots();
+	Seen = Version.load(std::memory_order_relaxed);
+	ValueTable::Slot const* S = Lookup(key,type,LookupKind::Handle);
+	if (S)
+		Out = Table.Get(*S);
+	return S;
+}
+
+/**
+ * @param S Slot returned by Pin()
+ * @param Seen Dictionary version returned by Pin()
+ * @param Out Set to the current value if `S` is still valid
+ * @return `True` if the dictionary has not changed since `S` was pinned
+ */
+bool Dict::ReadPinned(ValueTable::Slot const* S, std::uint64_t Seen, ValueTable::Value &Out) const
+{
+	LockScope lock(DictMutex);
+	if (Version.load(std::memory_order_relaxed) != Seen)
+		return false;
+	Out = Table.Get(*S);
+	return true;
+}
+
+/**
+ * @param key Key that could not be found
+ * @param type Type of the value
+ * @throw std::out_of_range always
+ */
+void Dict::HandleMiss(std::string const &key, ValueType type) const
+{
+	switch (type) {
+		case ValueType::Int:
+			ReportMissing(key,"int map (maybe this isn't a int?)");
+			break;
+		case ValueType::Double:
+			ReportMissing(key,"doubles map (maybe this isn't a double?)");
+			break;
+		case ValueType::String:
+			ReportMissing(key,"string map (maybe this isn't a string?)");
+			break;
+		case ValueType::IntArray:
+		case ValueType::DoubleArray:
+			break; //Handles do not hold arrays
+	}
+	throw std::out_of_range("Dict::Handle::Get");
+}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param type Type of the value
+ * @param val Value added with key `key`
+ * @return `True` if `key` was added, `False` if it was already present
+ * @note Nothing is written when `key` is present, so pinned handles and the
+ * 	sorted index stay valid.
+ */
+template <class T>
+bool Dict::AddNew(std::string_view key, ValueType type, T const &val)
+{
+	LockScope lock(DictMutex);
+	std::size_t hash = ValueTable::HashKey(key);
+	if (Table.Find(key,hash,type) != ValueTable::npos)
+		return false;
+	WriteScope W(*this);
+	std::size_t i = Table.Emplace(key,hash,type).first;
+	Table.Set(Table.Mutable(i),val);
+	return true;
+}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param val Value added with key `key`
+ * @return `True` if successful, `False` otherwise
+*/
+bool Dict::add(std::string_view Key, double value)
+{
+	return AddNew(Key,ValueType::Double,value);
+}
+
+//integer overload for Dict::add
+bool Dict::add(std::string_view Key, int value)
+{
+	return AddNew(Key,ValueType::Int,value);
+}
+
+//std::string overload for Dict::add
+bool Dict::add(std::string_view Key, std::string_view value)
+{
+	return AddNew(Key,ValueType::String,value);
+}
+
+//int array overload for Dict::add
+bool Dict::add(std::string_view Key, Span<const int> value)
+{
+	return AddNew(Key,ValueType::IntArray,value);
+}
+
+//double array overload for Dict::add
+bool Dict::add(std::string_view Key, Span<const double> value)
+{
+	return AddNew(Key,ValueType::DoubleArray,value);
+}
+
+//mapped array overload for Dict::add
+bool Dict::add(std::string_view Key, MappedArray const &value)
+{
+	return AddNew(Key,value.GetType(),value);
+}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param val Value set with key `key`
+*/
+void Dict::set(std::string_view Key, double value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,ValueType::Double).first,value);
+}
+
+//integer overload for Dict::set
+void Dict::set(std::string_view Key, int value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,ValueType::Int).first,value);
+}
+
+//std::string overload for Dict::set
+void Dict::set(std::string_view Key, std::string_view value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,ValueType::String).first,value);
+}
+
+//int array overload for Dict::set
+void Dict::set(std::string_view Key, Span<const int> value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,ValueType::IntArray).first,value);
+}
+
+//double array overload for Dict::set
+void Dict::set(std::string_view Key, Span<const double> value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,ValueType::DoubleArray).first,value);
+}
+
+//mapped array overload for Dict::set
+void Dict::set(std::string_view Key, MappedArray const &value)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	Table.Set(*Insert(Key,value.GetType()).first,value);
+}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param val Value set with key `key`
+*/
+void Dict::try_set(std::string_view Key, double value)
+{
+	AddNew(Key,ValueType::Double,value);
+}
+
+//integer overload for Dict::try_set
+void Dict::try_set(std::string_view Key, int value)
+{
+	AddNew(Key,ValueType::Int,value);
+}
+
+//std::string overload for Dict::try_set
+void Dict::try_set(std::string_view Key, std::string_view value)
+{
+	AddNew(Key,ValueType::String,value);
+}
+
+//int array overload for Dict::try_set
+void Dict::try_set(std::string_view Key, Span<const int> value)
+{
+	AddNew(Key,ValueType::IntArray,value);
+}
+
+//double array overload for Dict::try_set
+void Dict::try_set(std::string_view Key, Span<const double> value)
+{
+	AddNew(Key,ValueType::DoubleArray,value);
+}
+
+//mapped array overload for Dict::try_set
+void Dict::try_set(std::string_view Key, MappedArray const &value)
+{
+	AddNew(Key,value.GetType(),value);
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+double Dict::GetDouble(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::Double,LookupKind::Get))
+			return S->Double;
+	}
+	ReportMissing(key,"doubles map (maybe this isn't a double?)");
+	throw std::out_of_range("Dict::GetDouble");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+int Dict::GetInt(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::Int,LookupKind::Get))
+			return S->Int;
+	}
+	ReportMissing(key,"int map (maybe this isn't a int?)");
+	throw std::out_of_range("Dict::GetInt");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+std::string Dict::GetString(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::Get))
+			return std::string(Table.StringOf(*S));
+	}
+	ReportMissing(key,"string map (maybe this isn't a string?)");
+	throw std::out_of_range("Dict::GetString");
+}
+
+/**
+ * @param key Value to look up
+ * @return View of the values corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+ * @note The values are not copied.  They stay valid (and unchanged) until
+ * 	the dictionary is destroyed or assigned to, even if `key` is replaced.
+*/
+Span<const int> Dict::GetIntArray(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::IntArray,LookupKind::Get))
+			return Table.IntsOf(*S);
+	}
+	ReportMissing(key,"int array map (maybe this isn't an int array?)");
+	throw std::out_of_range("Dict::GetIntArray");
+}
+
+//double version of Dict::GetIntArray
+Span<const double> Dict::GetDoubleArray(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::DoubleArray,LookupKind::Get))
+			return Table.DoublesOf(*S);
+	}
+	ReportMissing(key,"double array map (maybe this isn't a double array?)");
+	throw std::out_of_range("Dict::GetDoubleArray");
+}
+
+/** @brief Checks if a string contains the word 'true' or 'false' (ignoring case)
+ * @param value    Value to test
+ * @returns true if value is 'true'
+ * @returns false if value is 'false'
+ * @returns `std::nullopt` if value is neither
+ */
+static std::optional<bool> ParseBool(std::string_view value)
+{
+	if (value.length() == 4) {
+		if (std::tolower(value[0]) == 't' &&
+		    std::tolower(value[1]) == 'r' &&
+		    std::tolower(value[2]) == 'u' &&
+		    std::tolower(value[3]) == 'e') return true;
+	} else if (value.length() == 5) {
+		if (std::tolower(value[0]) == 'f' &&
+		    std::tolower(value[1]) == 'a' &&
+		    std::tolower(value[2]) == 'l' &&
+		    std::tolower(value[3]) == 's' &&
+		    std::tolower(value[4]) == 'e') return false;
+	}
+	return std::nullopt;
+}
+
+/** @brief Checks if a string contains the word 'true' or 'false'
+ * @param value    Value to test
+ * @returns true if value is 'true'
+ * @returns false if value is 'false'
+ * @throws std::runtime_error if value is not 'true' or 'false'
+ */
+static bool CheckIfStringTrueOrFalse(std::string_view value)
+{
+	if (std::optional<bool> ret = ParseBool(value))
+		return *ret;
+	throw std::runtime_error("Unable to convert string to bool");
+}
+
+/**
+ * @param key Value to look up
+ * @return true if string at `key` is "true"
+ * @return false if string at `key` is "false"
+ * @throw std::out_of_range if value cannot be found
+ * @throw std::runtime_error if value is neither true or false
+ */
+bool Dict::GetBool(std::string_view key) const
+{
+	{
+		LockScope lock(DictMutex);
+		if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::Get))
+			return CheckIfStringTrueOrFalse(Table.StringOf(*S));
+	}
+	ReportMissing(key,"string map (maybe this isn't a string?)");
+	throw std::out_of_range("Dict::GetBool");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`, or `std::nullopt` if it cannot be found
+ * @note Unlike GetDouble(), this never throws or prints; the dictionary is
+ * 	probed once under a single lock.
+*/
+std::optional<double> Dict::TryGetDouble(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::Double,LookupKind::TryGet))
+		return S->Double;
+	return std::nullopt;
+}
+
+//int version of Dict::TryGetDouble
+std::optional<int> Dict::TryGetInt(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::Int,LookupKind::TryGet))
+		return S->Int;
+	return std::nullopt;
+}
+
+//std::string version of Dict::TryGetDouble
+std::optional<std::string> Dict::TryGetString(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::TryGet))
+		return std::string(Table.StringOf(*S));
+	return std::nullopt;
+}
+
+//int array version of Dict::TryGetDouble (see Dict::GetIntArray for the lifetime of the view)
+std::optional<Span<const int>> Dict::TryGetIntArray(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::IntArray,LookupKind::TryGet))
+		return Table.IntsOf(*S);
+	return std::nullopt;
+}
+
+//double array version of Dict::TryGetDouble (see Dict::GetIntArray for the lifetime of the view)
+std::optional<Span<const double>> Dict::TryGetDoubleArray(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::DoubleArray,LookupKind::TryGet))
+		return Table.DoublesOf(*S);
+	return std::nullopt;
+}
+
+/**
+ * @param key Value to look up
+ * @return Boolean held by the string at `key`, or `std::nullopt` if it cannot
+ * 	be found or is neither "true" nor "false"
+*/
+std::optional<bool> Dict::TryGetBool(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::TryGet))
+		return ParseBool(Table.StringOf(*S));
+	return std::nullopt;
+}
+
+/** @brief Keys between the prefetch of a slot and its probe in Dict::GetMany() */
+static constexpr std::size_t LookupPrefetchDistance = 8;
+
+/**
+ * @param Keys Keys to look up, each with the type of value wanted
+ * @param Out Receives the result for `Keys[i]` in `Out[i]` (reusing the
+ * 	capacity of its strings)
+ * @return Number of keys found
+ * @throw std::invalid_argument if `Out` is shorter than `Keys`
+ *
+ * The keys are hashed before the lock is taken (unless their hash is
+ * given), and the lock is then held once for all of them.  While one key
+ * is probed the first slot of a key a few places further on is
+ * prefetched, so the cache misses of successive lookups overlap.
+ * @note A key that is missing or of another type is reported through
+ * 	KeyResult::Found only; nothing is printed.
+*/
+std::size_t Dict::GetMany(Span<const KeyRequest> Keys, Span<KeyResult> Out) const
+{
+	if (Out.size() < Keys.size())
+		throw std::invalid_argument("Dict::GetMany: fewer results than keys");
+	std::size_t n = Keys.size();
+	static thread_local std::vector<std::size_t> Hashes;
+	Hashes.resize(n);
+	for (std::size_t i = 0; i < n; i++)
+		Hashes[i] = Keys[i].Hash ? Keys[i].Hash : ValueTable::HashKey(Keys[i].Key);
+
+	std::size_t Found = 0;
+	LockScope lock(DictMutex);
+	for (std::size_t i = 0; i < n && i < LookupPrefetchDistance; i++)
+		Table.Prefetch(Hashes[i]);
+	for (std::size_t i = 0; i < n; i++) {
+		if (i + LookupPrefetchDistance < n)
+			Table.Prefetch(Hashes[i + LookupPrefetchDistance]);
+		KeyRequest const &K = Keys[i];
+		KeyResult &R = Out[i];
+		std::size_t s = Table.Find(K.Key,Hashes[i],K.Type);
+		CountLookup(K.Key,Hashes[i],K.Type,LookupKind::TryGet,s != ValueTable::npos);
+		R.Found = (s != ValueTable::npos);
+		if (!R.Found)
+			continue;
+		Found++;
+		ValueTable::Slot const &S = Table[s];
+		switch (K.Type) {
+			case ValueType::Int: R.Int = S.Int; break;
+			case ValueType::Double: R.Double = S.Double; break;
+			case ValueType::String: R.String.assign(Table.StringOf(S)); break;
+			case ValueType::IntArray: R.Ints = Table.IntsOf(S); break;
+			case ValueType::DoubleArray: R.Doubles = Table.DoublesOf(S); break;
+		}
+	}
+	return Found;
+}
+
+/**
+ * @param key Value to look up
+ * @param def Value returned if `key` cannot be found
+ * @return Value corresponding to `key`, or `def`
+*/
+double Dict::GetOr(std::string_view key, double def) const
+{
+	return TryGetDouble(key).value_or(def);
+}
+
+//int overload for Dict::GetOr
+int Dict::GetOr(std::string_view key, int def) const
+{
+	return TryGetInt(key).value_or(def);
+}
+
+//std::string overload for Dict::GetOr
+std::string Dict::GetOr(std::string_view key, std::string const &def) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::TryGet))
+		return std::string(Table.StringOf(*S));
+	return def;
+}
+
+//String literal overload for Dict::GetOr (avoids conversion to bool)
+std::string Dict::GetOr(std::string_view key, const char* def) const
+{
+	LockScope lock(DictMutex);
+	if (ValueTable::Slot const* S = Lookup(key,ValueType::String,LookupKind::TryGet))
+		return std::string(Table.StringOf(*S));
+	return std::string(def);
+}
+
+//bool overload for Dict::GetOr (also used if the string is neither "true" nor "false")
+bool Dict::GetOr(std::string_view key, bool def) const
+{
+	return TryGetBool(key).value_or(def);
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool Dict::CheckDouble(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	return Lookup(key,ValueType::Double,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool Dict::CheckInt(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	return Lookup(key,ValueType::Int,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool Dict::CheckString(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	return Lookup(key,ValueType::String,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists as an array of `int`
+*/
+bool Dict::CheckIntArray(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	return Lookup(key,ValueType::IntArray,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists as an array of `double`
+*/
+bool Dict::CheckDoubleArray(std::string_view key) const
+{
+	LockScope lock(DictMutex);
+	return Lookup(key,ValueType::DoubleArray,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Key to remove
+ * @param type Type of the value to remove
+ * @return `True` if `key` existed with type `type`
+ */
+bool Dict::erase(std::string_view key, ValueType type)
+{
+	LockScope lock(DictMutex);
+	std::size_t i = Table.Find(key,ValueTable::HashKey(key),type);
+	if (i == ValueTable::npos)
+		return false;
+	WriteScope W(*this);
+	Table.Erase(i);
+	return true;
+}
+
+//all-types overload for Dict::erase
+bool Dict::erase(std::string_view key)
+{
+	bool erased = erase(key,ValueType::Int);
+	erased = erase(key,ValueType::Double) || erased;
+	erased = erase(key,ValueType::String) || erased;
+	erased = erase(key,ValueType::IntArray) || erased;
+	return erase(key,ValueType::DoubleArray) || erased;
+}
+
+/** @brief Arena bytes taken by the value of a slot (none for numbers and mapped arrays) */
+static std::size_t ArenaBytesOf(ValueTable::Slot const &S)
+{
+	if (S.Mapped)
+		return 0;
+	switch (S.Type()) {
+		case ValueType::String: return S.Str.Length;
+		case ValueType::IntArray: return S.Str.Length * sizeof(int);
+		case ValueType::DoubleArray: return S.Str.Length * sizeof(double);
+		default: return 0;
+	}
+}
+
+/** @brief Stale arena bytes above which ApplyChanges() considers compacting */
+static constexpr std::size_t CompactThreshold = std::size_t(64) << 10;
+
+/**
+ * @param Changes Values to add, replace or remove
+ * @note Replaced strings and arrays stay in the arena, so a long-running
+ * 	watcher would grow it with every reload.  Once their bytes exceed
+ * 	CompactThreshold and half of the arena, the table is rebuilt with
+ * 	ValueTable::Compacted(), as if it had been assigned to.
+ */
+void Dict::ApplyChanges(std::vector<ConfigChange> const &Changes)
+{
+	LockScope lock(DictMutex);
+	WriteScope W(*this);
+	for (ConfigChange const &C : Changes) {
+		if (C.Change == ConfigChange::Kind::Removed) {
+			std::size_t i = Table.Find(C.Key,ValueTable::HashKey(C.Key),C.Type);
+			if (i != ValueTable::npos) {
+				StaleArena += ArenaBytesOf(Table[i]);
+				Table.Erase(i);
+			}
+			continue;
+		}
+		auto [S, Created] = Insert(C.Key,C.Type);
+		if (!Created)
+			StaleArena += ArenaBytesOf(*S);
+		if (C.Mapped)
+			Table.Set(*S,*C.Mapped);
+		else
+			Table.Set(*S,C.New);
+	}
+	if (StaleArena > CompactThreshold && 2 * StaleArena > Table.Memory().ArenaUsed) {
+		Table = Table.Compacted();
+		StaleArena = 0;
+	}
+}
+
+/**
+ * @brief Prints the contents of a value table to stdout
+ * @param Table         Table being printed
+ */
+static void DumpTable(ValueTable const &Table)
+{
+	using std::cout, std::endl, std::setw;
+	double Slots = (Table.Capacity() > 0) ? static_cast<double>(Table.Capacity()) : 1.0;
+	cout << "Dictionary Dump" << endl << endl << "+->Integer Database" << endl;
+	//Dump Integers
+	cout << "+--->Size: " << Table.Size(ValueType::Int) << endl;
+	cout << "+---># of Buckets: " << Table.Capacity() << endl;
+	cout << "+--->Load Factor: " << Table.Size(ValueType::Int) / Slots << endl;
+	for (std::size_t i = 0; i < Table.Capacity(); i++)
+		if (!Table[i].Empty() && Table[i].Type() == ValueType::Int)
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ": " << Table[i].Int << endl;
+
+	//Dump Floats
+	cout << "+--->Size: " << Table.Size(ValueType::Double) << endl;
+	cout << "+---># of Buckets: " << Table.Capacity() << endl;
+	cout << "+--->Load Factor: " << Table.Size(ValueType::Double) / Slots << endl;
+	for (std::size_t i = 0; i < Table.Capacity(); i++)
+		if (!Table[i].Empty() && Table[i].Type() == ValueType::Double)
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ": " << Table[i].Double << endl;
+
+	//Dump Strings
+	cout << "+--->Size: " << Table.Size(ValueType::String) << endl;
+	cout << "+---># of Buckets: " << Table.Capacity() << endl;
+	cout << "+--->Load Factor: " << Table.Size(ValueType::String) / Slots << endl;
+	for (std::size_t i = 0; i < Table.Capacity(); i++)
+		if (!Table[i].Empty() && Table[i].Type() == ValueType::String)
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ": " << Table.StringOf(Table[i]) << endl;
+
+	//Dump Arrays (only if there are any, so that dumps without arrays are unchanged)
+	if (Table.Size(ValueType::IntArray) + Table.Size(ValueType::DoubleArray) == 0)
+		return;
+	cout << "+--->Arrays: " << Table.Size(ValueType::IntArray) << " int, " << Table.Size(ValueType::DoubleArray) << " double" << endl;
+	for (std::size_t i = 0; i < Table.Capacity(); i++) {
+		if (Table[i].Empty())
+			continue;
+		if (MappedArray const* M = Table.MappingOf(Table[i])) {
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ": mapped, " << M->size() << " values" << endl;
+		} else if (Table[i].Type() == ValueType::IntArray) {
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ":";
+			for (int v : Table.IntsOf(Table[i]))
+				cout << ' ' << v;
+			cout << endl;
+		} else if (Table[i].Type() == ValueType::DoubleArray) {
+			cout << setw(20) << std::left << Table.KeyOf(Table[i]) << ":";
+			for (double v : Table.DoublesOf(Table[i]))
+				cout << ' ' << v;
+			cout << endl;
+		}
+	}
+}
+
+//Printout all values from the dictionary
+void Dict::Dump() const
+{
+	LockScope lock(DictMutex);
+	DumpTable(Table);
+}
+
+/**
+ * @return Bytes held by the dictionary's slot array, string arena and
+ * 	interning index, with the number of values they hold
+ */
+MemoryStats Dict::Memory() const
+{
+	LockScope lock(DictMutex);
+	return Table.Memory();
+}
+
+/**
+ * @return Indices of the occupied slots, sorted by key and then type
+ * @note The index is built on first use and rebuilt after any modification,
+ * 	so a dictionary that is never searched by prefix pays nothing for it.
+ */
+std::vector<std::size_t> const& Dict::Sorted() const
+{
+	std::uint64_t Current = Version.load(std::memory_order_relaxed);
+	if (SortedVersion == Current)
+		return SortedSlots;
+	//Sort the keys themselves rather than slot indices, so that comparisons do not chase pointers
+	std::vector<std::tuple<std::string_view,unsigned char,std::size_t>> Keys;
+	Keys.reserve(Table.Size());
+	for (std::size_t i = 0; i < Table.Capacity(); i++)
+		if (!Table[i].Empty())
+			Keys.emplace_back(Table.KeyOf(Table[i]),Table[i].Tag,i);
+	std::sort(Keys.begin(),Keys.end());
+	SortedSlots.resize(Keys.size());
+	for (std::size_t i = 0; i < Keys.size(); i++)
+		SortedSlots[i] = std::get<2>(Keys[i]);
+	SortedVersion = Current;
+	return SortedSlots;
+}
+
+/**
+ * @param prefix Start of the keys to return
+ * @return Key, type and value of every entry whose key starts with `prefix`,
+ * 	viewing the dictionary's storage (valid until it is next written)
+ * @note Costs O(log n + k) once the sorted index is built.
+ */
+std::vector<DictEntry> Dict::Prefix(std::string_view prefix) const
+{
+	std::vector<DictEntry> Out;
+	Scan(prefix,std::string_view(),true,[&](std::string_view key, ValueTable::Slot const &S) {
+		Out.push_back(DictEntry{key,S.Type(),Table.ViewOf(S)});
+	});
+	return Out;
+}
+
+/**
+ * @param first Lowest key to return
+ * @param last Key above the last one to return
+ * @return Key, type and value of every entry whose key lies in [`first`, `last`),
+ * 	viewing the dictionary's storage (valid until it is next written)
+ * @note Costs O(log n + k) once the sorted index is built.
+ */
+std::vector<DictEntry> Dict::Range(std::string_view first, std::string_view last) const
+{
+	std::vector<DictEntry> Out;
+	Scan(first,last,false,[&](std::string_view key, ValueTable::Slot const &S) {
+		Out.push_back(DictEntry{key,S.Type(),Table.ViewOf(S)});
+	});
+	return Out;
+}
+
+/**
+ * @param PerfectHash Whether to build a perfect hash of the keys for lookups (see FrozenDict)
+ * @return Snapshot holding a copy of every value currently in the dictionary
+ * @note The dictionary is locked only while it is copied, not while the
+ * 	perfect hash is built.
+ */
+std::shared_ptr<const FrozenDict> Dict::Freeze(bool PerfectHash /*=false*/) const
+{
+	ValueTable Copy;
+	std::string Name;
+	{
+		LockScope lock(DictMutex);
+		Copy = Table;
+		Name = Filename;
+	}
+	return std::make_shared<const FrozenDict>(std::move(Copy),std::move(Name),PerfectHash);
+}
+
+/**
+ * @param Table_ Values of the snapshot
+ * @param Filename_ File the values were read from
+ * @param PerfectHash Whether to build a perfect hash of the keys
+ * @note If two entries have the same EntryHash() (which is very unlikely)
+ * 	no perfect hash is built and lookups use the table.
+ */
+FrozenDict::FrozenDict(ValueTable Table_, std::string Filename_, bool PerfectHash) :
+	Table(std::move(Table_)),
+	Filename(std::move(Filename_))
+{
+	std::size_t n = Table.Size();
+	if (!PerfectHash || n == 0)
+		return;
+	std::vector<std::uint64_t> Hashes;
+	std::vector<std::size_t> Index; //Slot of each hash
+	Hashes.reserve(n);
+	Index.reserve(n);
+	for (std::size_t i = 0; i < Table.Capacity(); i++) {
+		if (Table[i].Empty())
+			continue;
+		Hashes.push_back(EntryHash(Table[i].Hash,Table[i].Type()));
+		Index.push_back(i);
+	}
+	std::vector<std::size_t> Order(n), Start(PerfectBuckets(n) + 1);
+	std::unique_ptr<bool[]> Taken(new bool[n]());
+	Seeds.resize(PerfectBuckets(n));
+	if (!BuildPerfectHash(Hashes.data(),n,Seeds.data(),Order.data(),Start.data(),Taken.get())) {
+		Seeds.clear();
+		return;
+	}
+	Dense.resize(n);
+	for (std::size_t i = 0; i < n; i++)
+		Dense[PerfectSlot(Hashes[i],Seeds.data(),n)] = Table[Index[i]];
+}
+
+/**
+ * @param key Value to look up
+ * @param type Type of the value
+ * @param kind Accessor looking up the value (for Stats)
+ * @return Slot holding `key`, or `nullptr` if not present
+ */
+ValueTable::Slot const* FrozenDict::Find(std::string_view key, ValueType type, LookupKind kind) const
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	ValueTable::Slot const* S = nullptr;
+	if (!Dense.empty()) {
+		ValueTable::Slot const &P = Dense[PerfectSlot(EntryHash(hash,type),Seeds.data(),Dense.size())];
+		if (P.Hash == hash && P.Type() == type && Table.KeyOf(P) == key)
+			S = &P;
+	} else {
+		std::size_t i = Table.Find(key,hash,type);
+		if (i != ValueTable::npos)
+			S = &Table[i];
+	}
+	CountLookup(key,hash,type,kind,S != nullptr);
+	return S;
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+double FrozenDict::GetDouble(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::Double,LookupKind::Get))
+		return S->Double;
+	ReportMissing(key,"doubles map (maybe this isn't a double?)");
+	throw std::out_of_range("FrozenDict::GetDouble");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+int FrozenDict::GetInt(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::Int,LookupKind::Get))
+		return S->Int;
+	ReportMissing(key,"int map (maybe this isn't a int?)");
+	throw std::out_of_range("FrozenDict::GetInt");
+}
+
+/**
+ * @param key Value to look up
+ * @return View of the value corresponding to `key`, valid for the
+ * 	lifetime of the snapshot
+ * @throw std::out_of_range if value cannot be found
+*/
+std::string_view FrozenDict::GetString(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::String,LookupKind::Get))
+		return Table.StringOf(*S);
+	ReportMissing(key,"string map (maybe this isn't a string?)");
+	throw std::out_of_range("FrozenDict::GetString");
+}
+
+/**
+ * @param key Value to look up
+ * @return true if string at `key` is "true"
+ * @return false if string at `key` is "false"
+ * @throw std::out_of_range if value cannot be found
+ * @throw std::runtime_error if value is neither true or false
+ */
+bool FrozenDict::GetBool(std::string_view key) const
+{
+	return CheckIfStringTrueOrFalse(GetString(key));
+}
+
+/**
+ * @param key Value to look up
+ * @return View of the values corresponding to `key` (valid for the lifetime of the snapshot)
+ * @throw std::out_of_range if value cannot be found
+*/
+Span<const int> FrozenDict::GetIntArray(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::IntArray,LookupKind::Get))
+		return Table.IntsOf(*S);
+	ReportMissing(key,"int array map (maybe this isn't an int array?)");
+	throw std::out_of_range("FrozenDict::GetIntArray");
+}
+
+//double version of FrozenDict::GetIntArray
+Span<const double> FrozenDict::GetDoubleArray(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::DoubleArray,LookupKind::Get))
+		return Table.DoublesOf(*S);
+	ReportMissing(key,"double array map (maybe this isn't a double array?)");
+	throw std::out_of_range("FrozenDict::GetDoubleArray");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`, or `std::nullopt` if it cannot be found
+*/
+std::optional<double> FrozenDict::TryGetDouble(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::Double,LookupKind::TryGet))
+		return S->Double;
+	return std::nullopt;
+}
+
+//int version of FrozenDict::TryGetDouble
+std::optional<int> FrozenDict::TryGetInt(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::Int,LookupKind::TryGet))
+		return S->Int;
+	return std::nullopt;
+}
+
+//std::string version of FrozenDict::TryGetDouble (the view is valid for the lifetime of the snapshot)
+std::optional<std::string_view> FrozenDict::TryGetString(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::String,LookupKind::TryGet))
+		return Table.StringOf(*S);
+	return std::nullopt;
+}
+
+//int array version of FrozenDict::TryGetDouble
+std::optional<Span<const int>> FrozenDict::TryGetIntArray(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::IntArray,LookupKind::TryGet))
+		return Table.IntsOf(*S);
+	return std::nullopt;
+}
+
+//double array version of FrozenDict::TryGetDouble
+std::optional<Span<const double>> FrozenDict::TryGetDoubleArray(std::string_view key) const
+{
+	if (ValueTable::Slot const* S = Find(key,ValueType::DoubleArray,LookupKind::TryGet))
+		return Table.DoublesOf(*S);
+	return std::nullopt;
+}
+
+//bool version of FrozenDict::TryGetDouble
+std::optional<bool> FrozenDict::TryGetBool(std::string_view key) const
+{
+	if (std::optional<std::string_view> S = TryGetString(key))
+		return ParseBool(*S);
+	return std::nullopt;
+}
+
+/**
+ * @param key Value to look up
+ * @param def Value returned if `key` cannot be found
+ * @return Value corresponding to `key`, or `def`
+ * @note The string overloads return a view of either the snapshot or `def`.
+*/
+double FrozenDict::GetOr(std::string_view key, double def) const
+{
+	return TryGetDouble(key).value_or(def);
+}
+
+//int overload for FrozenDict::GetOr
+int FrozenDict::GetOr(std::string_view key, int def) const
+{
+	return TryGetInt(key).value_or(def);
+}
+
+//std::string_view overload for FrozenDict::GetOr
+std::string_view FrozenDict::GetOr(std::string_view key, std::string_view def) const
+{
+	return TryGetString(key).value_or(def);
+}
+
+//String literal overload for FrozenDict::GetOr (avoids conversion to bool)
+std::string_view FrozenDict::GetOr(std::string_view key, const char* def) const
+{
+	return TryGetString(key).value_or(std::string_view(def));
+}
+
+//bool overload for FrozenDict::GetOr
+bool FrozenDict::GetOr(std::string_view key, bool def) const
+{
+	return TryGetBool(key).value_or(def);
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool FrozenDict::CheckDouble(std::string_view key) const
+{
+	return Find(key,ValueType::Double,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool FrozenDict::CheckInt(std::string_view key) const
+{
+	return Find(key,ValueType::Int,LookupKind::Check) != nullptr;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool FrozenDict::CheckString(std::string_view key) const
+{
+	return Find(key,ValueType::String,LookupKind::Check) != nullptr;
+}
+
+//int array version of FrozenDict::CheckString
+bool FrozenDict::CheckIntArray(std::string_view key) const
+{
+	return Find(key,ValueType::IntArray,LookupKind::Check) != nullptr;
+}
+
+//double array version of FrozenDict::CheckString
+bool FrozenDict::CheckDoubleArray(std::string_view key) const
+{
+	return Find(key,ValueType::DoubleArray,LookupKind::Check) != nullptr;
+}
+
+//Printout all values from the snapshot
+void FrozenDict::Dump() const
+{
+	DumpTable(Table);
+	if (!Dense.empty())
+		std::cout << "+->Perfect hash: " << Dense.size() << " entries, " << Seeds.size() << " buckets (one probe per lookup)" << std::endl;
+}
+
+/**
+ * @return Memory held by the values, with the dense slots and seeds of the
+ * 	perfect hash counted as slots
+ */
+MemoryStats FrozenDict::Memory() const
+{
+	MemoryStats M = Table.Memory();
+	M.SlotBytes += Dense.size() * sizeof(ValueTable::Slot) + Seeds.size() * sizeof(std::uint32_t);
+	return M;
+}
+
+/**
+ * @param ShardCount Number of shards; more shards let more threads write at
+ * 	once at the cost of a table (and its growth) per shard
+ */
+ConcurrentDict::ConcurrentDict(unsigned ShardCount)
+{
+	unsigned Bits = 0;
+	while ((std::size_t(1) << Bits) < ShardCount && Bits < 16)
+		Bits++;
+	Shards.reset(new Shard[std::size_t(1) << Bits]);
+	ShardMask = (std::size_t(1) << Bits) - 1;
+	ShardShift = static_cast<unsigned>(std::numeric_limits<std::size_t>::digits) - 1 - Bits;
+}
+
+/**
+ * @param D Dictionary to copy (locked while it is copied)
+ * @param ShardCount Number of shards (see ConcurrentDict(unsigned))
+ */
+ConcurrentDict::ConcurrentDict(Dict const &D, unsigned ShardCount) : ConcurrentDict(ShardCount)
+{
+	Dict::LockScope lock(D.DictMutex);
+	Filename = D.Filename;
+	for (std::size_t i = 0; i < D.Table.Capacity(); i++) {
+		ValueTable::Slot const &From = D.Table[i];
+		if (From.Empty())
+			continue;
+		ValueTable &T = ShardOf(From.Hash).Table;
+		std::size_t j = T.Emplace(D.Table.KeyOf(From),From.Hash,From.Type()).first;
+		T.Set(T.Mutable(j),D.Table,From);
+	}
+}
+
+/**
+ * @param key Key to store
+ * @param type Type of `val`
+ * @param val Value to store
+ * @param overwrite Whether to replace an existing value
+ * @return `True` if `key` did not exist with type `type`
+ */
+template <class T>
+bool ConcurrentDict::Store(std::string_view key, ValueType type, T const &val, bool overwrite)
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	Shard &S = ShardOf(hash);
+	std::unique_lock<std::shared_mutex> lock(S.Mutex);
+	auto [i, inserted] = S.Table.Emplace(key,hash,type);
+	if (inserted || overwrite)
+		S.Table.Set(S.Table.Mutable(i),val);
+	return inserted;
+}
+
+/**
+ * @param key Key to look up
+ * @param type Type of the value
+ * @param kind Accessor looking up the value (for Stats)
+ * @param f Called with the table and slot holding the value
+ * @return `True` if the value was found (and `f` called)
+ */
+template <class F>
+bool ConcurrentDict::Visit(std::string_view key, ValueType type, LookupKind kind, F &&f) const
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	Shard const &S = ShardOf(hash);
+	std::shared_lock<std::shared_mutex> lock(S.Mutex);
+	std::size_t i = S.Table.Find(key,hash,type);
+	CountLookup(key,hash,type,kind,i != ValueTable::npos);
+	if (i == ValueTable::npos)
+		return false;
+	f(S.Table,S.Table[i]);
+	return true;
+}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param val Value added with key `key`
+ * @return `True` if successful, `False` otherwise
+*/
+bool ConcurrentDict::add(std::string_view key, double val) {return Store(key,ValueType::Double,val,false);}
+//integer overload for ConcurrentDict::add
+bool ConcurrentDict::add(std::string_view key, int val) {return Store(key,ValueType::Int,val,false);}
+//std::string overload for ConcurrentDict::add
+bool ConcurrentDict::add(std::string_view key, std::string_view val) {return Store(key,ValueType::String,val,false);}
+//int array overload for ConcurrentDict::add
+bool ConcurrentDict::add(std::string_view key, Span<const int> val) {return Store(key,ValueType::IntArray,val,false);}
+//double array overload for ConcurrentDict::add
+bool ConcurrentDict::add(std::string_view key, Span<const double> val) {return Store(key,ValueType::DoubleArray,val,false);}
+
+/**
+ * @param key Lookup value corresponding to `val`
+ * @param val Value set with key `key`
+ * @note Only the shard holding `key` is locked.
+*/
+void ConcurrentDict::set(std::string_view key, double val) {Store(key,ValueType::Double,val,true);}
+//integer overload for ConcurrentDict::set
+void ConcurrentDict::set(std::string_view key, int val) {Store(key,ValueType::Int,val,true);}
+//std::string overload for ConcurrentDict::set
+void ConcurrentDict::set(std::string_view key, std::string_view val) {Store(key,ValueType::String,val,true);}
+//int array overload for ConcurrentDict::set
+void ConcurrentDict::set(std::string_view key, Span<const int> val) {Store(key,ValueType::IntArray,val,true);}
+//double array overload for ConcurrentDict::set
+void ConcurrentDict::set(std::string_view key, Span<const double> val) {Store(key,ValueType::DoubleArray,val,true);}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+double ConcurrentDict::GetDouble(std::string_view key) const
+{
+	std::optional<double> val;
+	Visit(key,ValueType::Double,LookupKind::Get,[&](ValueTable const&, ValueTable::Slot const &S) {val = S.Double;});
+	if (val)
+		return *val;
+	ReportMissing(key,"doubles map (maybe this isn't a double?)");
+	throw std::out_of_range("ConcurrentDict::GetDouble");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+int ConcurrentDict::GetInt(std::string_view key) const
+{
+	std::optional<int> val;
+	Visit(key,ValueType::Int,LookupKind::Get,[&](ValueTable const&, ValueTable::Slot const &S) {val = S.Int;});
+	if (val)
+		return *val;
+	ReportMissing(key,"int map (maybe this isn't a int?)");
+	throw std::out_of_range("ConcurrentDict::GetInt");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+*/
+std::string ConcurrentDict::GetString(std::string_view key) const
+{
+	std::optional<std::string> val;
+	Visit(key,ValueType::String,LookupKind::Get,[&](ValueTable const &T, ValueTable::Slot const &S) {val.emplace(T.StringOf(S));});
+	if (val)
+		return std::move(*val);
+	ReportMissing(key,"string map (maybe this isn't a string?)");
+	throw std::out_of_range("ConcurrentDict::GetString");
+}
+
+/**
+ * @param key Value to look up
+ * @return true if string at `key` is "true"
+ * @return false if string at `key` is "false"
+ * @throw std::out_of_range if value cannot be found
+ * @throw std::runtime_error if value is neither true or false
+ */
+bool ConcurrentDict::GetBool(std::string_view key) const
+{
+	return CheckIfStringTrueOrFalse(GetString(key));
+}
+
+/**
+ * @param key Value to look up
+ * @return View of the values corresponding to `key`
+ * @throw std::out_of_range if value cannot be found
+ * @note The values are not copied.  They stay valid (and unchanged) until
+ * 	the dictionary is destroyed, even if `key` is replaced.
+*/
+Span<const int> ConcurrentDict::GetIntArray(std::string_view key) const
+{
+	std::optional<Span<const int>> val;
+	Visit(key,ValueType::IntArray,LookupKind::Get,[&](ValueTable const &T, ValueTable::Slot const &S) {val = T.IntsOf(S);});
+	if (val)
+		return *val;
+	ReportMissing(key,"int array map (maybe this isn't an int array?)");
+	throw std::out_of_range("ConcurrentDict::GetIntArray");
+}
+
+//double version of ConcurrentDict::GetIntArray
+Span<const double> ConcurrentDict::GetDoubleArray(std::string_view key) const
+{
+	std::optional<Span<const double>> val;
+	Visit(key,ValueType::DoubleArray,LookupKind::Get,[&](ValueTable const &T, ValueTable::Slot const &S) {val = T.DoublesOf(S);});
+	if (val)
+		return *val;
+	ReportMissing(key,"double array map (maybe this isn't a double array?)");
+	throw std::out_of_range("ConcurrentDict::GetDoubleArray");
+}
+
+/**
+ * @param key Value to look up
+ * @return Value corresponding to `key`, or `std::nullopt` if it cannot be found
+ * @note Only the shard holding `key` is locked, and only against writers.
+*/
+std::optional<double> ConcurrentDict::TryGetDouble(std::string_view key) const
+{
+	std::optional<double> Out;
+	Visit(key,ValueType::Double,LookupKind::TryGet,[&](ValueTable const&, ValueTable::Slot const &S) {Out = S.Double;});
+	return Out;
+}
+
+//int version of ConcurrentDict::TryGetDouble
+std::optional<int> ConcurrentDict::TryGetInt(std::string_view key) const
+{
+	std::optional<int> Out;
+	Visit(key,ValueType::Int,LookupKind::TryGet,[&](ValueTable const&, ValueTable::Slot const &S) {Out = S.Int;});
+	return Out;
+}
+
+//std::string version of ConcurrentDict::TryGetDouble
+std::optional<std::string> ConcurrentDict::TryGetString(std::string_view key) const
+{
+	std::optional<std::string> Out;
+	Visit(key,ValueType::String,LookupKind::TryGet,[&](ValueTable const &T, ValueTable::Slot const &S) {Out.emplace(T.StringOf(S));});
+	return Out;
+}
+
+//int array version of ConcurrentDict::TryGetDouble (see ConcurrentDict::GetIntArray for the lifetime of the view)
+std::optional<Span<const int>> ConcurrentDict::TryGetIntArray(std::string_view key) const
+{
+	std::optional<Span<const int>> Out;
+	Visit(key,ValueType::IntArray,LookupKind::TryGet,[&](ValueTable const &T, ValueTable::Slot const &S) {Out = T.IntsOf(S);});
+	return Out;
+}
+
+//double array version of ConcurrentDict::TryGetDouble (see ConcurrentDict::GetIntArray for the lifetime of the view)
+std::optional<Span<const double>> ConcurrentDict::TryGetDoubleArray(std::string_view key) const
+{
+	std::optional<Span<const double>> Out;
+	Visit(key,ValueType::DoubleArray,LookupKind::TryGet,[&](ValueTable const &T, ValueTable::Slot const &S) {Out = T.DoublesOf(S);});
+	return Out;
+}
+
+/**
+ * @param key Value to look up
+ * @return Boolean held by the string at `key`, or `std::nullopt` if it cannot
+ * 	be found or is neither "true" nor "false"
+*/
+std::optional<bool> ConcurrentDict::TryGetBool(std::string_view key) const
+{
+	std::optional<bool> Out;
+	Visit(key,ValueType::String,LookupKind::TryGet,[&](ValueTable const &T, ValueTable::Slot const &S) {Out = ParseBool(T.StringOf(S));});
+	return Out;
+}
+
+/**
+ * @param key Value to look up
+ * @return `True` if `key` exists, `False` otherwise
+*/
+bool ConcurrentDict::CheckDouble(std::string_view key) const {return Visit(key,ValueType::Double,LookupKind::Check,[](ValueTable const&, ValueTable::Slot const&) {});}
+//int version of ConcurrentDict::CheckDouble
+bool ConcurrentDict::CheckInt(std::string_view key) const {return Visit(key,ValueType::Int,LookupKind::Check,[](ValueTable const&, ValueTable::Slot const&) {});}
+//std::string version of ConcurrentDict::CheckDouble
+bool ConcurrentDict::CheckString(std::string_view key) const {return Visit(key,ValueType::String,LookupKind::Check,[](ValueTable const&, ValueTable::Slot const&) {});}
+//int array version of ConcurrentDict::CheckDouble
+bool ConcurrentDict::CheckIntArray(std::string_view key) const {return Visit(key,ValueType::IntArray,LookupKind::Check,[](ValueTable const&, ValueTable::Slot const&) {});}
+//double array version of ConcurrentDict::CheckDouble
+bool ConcurrentDict::CheckDoubleArray(std::string_view key) const {return Visit(key,ValueType::DoubleArray,LookupKind::Check,[](ValueTable const&, ValueTable::Slot const&) {});}
+
+/**
+ * @param key Key to remove
+ * @param type Type of the value to remove
+ * @return `True` if `key` existed with type `type`
+ */
+bool ConcurrentDict::erase(std::string_view key, ValueType type)
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	Shard &S = ShardOf(hash);
+	std::unique_lock<std::shared_mutex> lock(S.Mutex);
+	std::size_t i = S.Table.Find(key,hash,type);
+	if (i == ValueTable::npos)
+		return false;
+	S.Table.Erase(i);
+	return true;
+}
+
+//all-types overload for ConcurrentDict::erase (every type of a key lives in the same shard)
+bool ConcurrentDict::erase(std::string_view key)
+{
+	std::size_t hash = ValueTable::HashKey(key);
+	Shard &S = ShardOf(hash);
+	std::unique_lock<std::shared_mutex> lock(S.Mutex);
+	bool erased = false;
+	for (ValueType type : {ValueType::Int,ValueType::Double,ValueType::String,ValueType::IntArray,ValueType::DoubleArray}) {
+		std::size_t i = S.Table.Find(key,hash,type);
+		if (i != ValueTable::npos) {
+			S.Table.Erase(i);
+			erased = true;
+		}
+	}
+	return erased;
+}
+
+//Printout all values from the dictionary (as one table)
+void ConcurrentDict::Dump() const
+{
+	Freeze()->Dump();
+}
+
+/**
+ * @return Bytes held by the shards' tables, with the number of values they hold
+ */
+MemoryStats ConcurrentDict::Memory() const
+{
+	MemoryStats M;
+	for (std::size_t s = 0; s <= ShardMask; s++) {
+		std::shared_lock<std::shared_mutex> lock(Shards[s].Mutex);
+		M += Shards[s].Table.Memory();
+	}
+	return M;
+}
+
+/**
+ * @param PerfectHash Whether to build a perfect hash of the keys for lookups (see FrozenDict)
+ * @return Snapshot holding a copy of every value currently in the dictionary
+ * @note Every shard is locked against writers (in order) while the values
+ * 	are copied, so the snapshot reflects a single point in time.
+ */
+std::shared_ptr<const FrozenDict> ConcurrentDict::Freeze(bool PerfectHash /*=false*/) const
+{
+	ValueTable Merged;
+	{
+		std::vector<std::shared_lock<std::shared_mutex>> Locks;
+		Locks.reserve(ShardMask + 1);
+		for (std::size_t s = 0; s <= ShardMask; s++)
+			Locks.emplace_back(Shards[s].Mutex);
+		for (std::size_t s = 0; s <= ShardMask; s++) {
+			ValueTable const &T = Shards[s].Table;
+			for (std::size_t i = 0; i < T.Capacity(); i++) {
+				ValueTable::Slot const &From = T[i];
+				if (From.Empty())
+					continue;
+				std::size_t j = Merged.Emplace(T.KeyOf(From),From.Hash,From.Type()).first;
+				Merged.Set(Merged.Mutable(j),T,From);
+			}
+		}
+	}
+	return std::make_shared<const FrozenDict>(std::move(Merged),Filename,PerfectHash);
+}
+
+/*
+	Token scanning
+
+	Lines are tokenized by two primitives: skipping blanks (' ' and '\t') and
+	finding the end of a word (' ', '\t', '#', '\n' or '\0').  Both have a
+	scalar version and, on x86, SSE2 and AVX2 versions which test 16 or 32
+	bytes per instruction.  The best version supported by the running CPU is
+	selected once, the first time a line is parsed.
+*/
+
+/** @brief Scans `n` bytes from `p`, returning the offset of the first match (or `n`) */
+using ScanFunction = std::size_t (*)(const char* p, std::size_t n);
+
+/** @brief Whether `c` ends a word */
+static inline bool IsDelimiter(char c)
+{
+	return c == ' ' || c == '\t' || c == '#' || c == '\n' || c == '\0';
+}
+
+//Scalar version of FindDelimiter
+static std::size_t FindDelimiterScalar(const char* p, std::size_t n)
+{
+	std::size_t i = 0;
+	while (i < n && !IsDelimiter(p[i]))
+		i++;
+	return i;
+}
+
+//Scalar version of SkipBlanks
+static std::size_t SkipBlanksScalar(const char* p, std::size_t n)
+{
+	std::size_t i = 0;
+	while (i < n && (p[i] == ' ' || p[i] == '\t'))
+		i++;
+	return i;
+}
+
+#ifdef PARSELI_HAVE_X86_SIMD
+//SSE2 version of FindDelimiter
+__attribute__((target("sse2")))
+static std::size_t FindDelimiterSSE2(const char* p, std::size_t n)
+{
+	const __m128i Space = _mm_set1_epi8(' ');
+	const __m128i Tab = _mm_set1_epi8('\t');
+	const __m128i Hash = _mm_set1_epi8('#');
+	const __m128i Newline = _mm_set1_epi8('\n');
+	const __m128i Null = _mm_setzero_si128();
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v,Space),_mm_cmpeq_epi8(v,Tab)),
+		                         _mm_or_si128(_mm_cmpeq_epi8(v,Hash),_mm_cmpeq_epi8(v,Newline)));
+		m = _mm_or_si128(m,_mm_cmpeq_epi8(v,Null));
+		unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+		if (mask)
+			return i + static_cast<std::size_t>(__builtin_ctz(mask));
+	}
+	return i + FindDelimiterScalar(p + i,n - i);
+}
+
+//SSE2 version of SkipBlanks
+__attribute__((target("sse2")))
+static std::size_t SkipBlanksSSE2(const char* p, std::size_t n)
+{
+	const __m128i Space = _mm_set1_epi8(' ');
+	const __m128i Tab = _mm_set1_epi8('\t');
+	std::size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+		__m128i m = _mm_or_si128(_mm_cmpeq_epi8(v,Space),_mm_cmpeq_epi8(v,Tab));
+		unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(m)) & 0xFFFFu;
+		if (mask)
+			return i + static_cast<std::size_t>(__builtin_ctz(mask));
+	}
+	return i + SkipBlanksScalar(p + i,n - i);
+}
+
+//AVX2 version of FindDelimiter
+__attribute__((target("avx2")))
+static std::size_t FindDelimiterAVX2(const char* p, std::size_t n)
+{
+	const __m256i Space = _mm256_set1_epi8(' ');
+	const __m256i Tab = _mm256_set1_epi8('\t');
+	const __m256i Hash = _mm256_set1_epi8('#');
+	const __m256i Newline = _mm256_set1_epi8('\n');
+	const __m256i Null = _mm256_setzero_si256();
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+		__m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v,Space),_mm256_cmpeq_epi8(v,Tab)),
+		                            _mm256_or_si256(_mm256_cmpeq_epi8(v,Hash),_mm256_cmpeq_epi8(v,Newline)));
+		m = _mm256_or_si256(m,_mm256_cmpeq_epi8(v,Null));
+		unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+		if (mask)
+			return i + static_cast<std::size_t>(__builtin_ctz(mask));
+	}
+	return i + FindDelimiterSSE2(p + i,n - i);
+}
+
+//AVX2 version of SkipBlanks
+__attribute__((target("avx2")))
+static std::size_t SkipBlanksAVX2(const char* p, std::size_t n)
+{
+	const __m256i Space = _mm256_set1_epi8(' ');
+	const __m256i Tab = _mm256_set1_epi8('\t');
+	std::size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+		__m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v,Space),_mm256_cmpeq_epi8(v,Tab));
+		unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(m));
+		if (mask)
+			return i + static_cast<std::size_t>(__builtin_ctz(mask));
+	}
+	return i + SkipBlanksSSE2(p + i,n - i);
+}
+#endif
+
+/** @brief Token scanning functions selected for the running CPU */
+struct TokenScanner
+{
+	ScanFunction FindDelimiter; ///<Finds the first character ending a word
+	ScanFunction SkipBlanks;    ///<Finds the first character that is not a blank
+};
+
+/**
+ * @brief Selects the fastest token scanner supported by the running CPU
+ * @returns Scanner using AVX2, SSE2 or scalar code
+ */
+static TokenScanner SelectTokenScanner()
+{
+#ifdef PARSELI_HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return {FindDelimiterAVX2,SkipBlanksAVX2};
+	if (__builtin_cpu_supports("sse2"))
+		return {FindDelimiterSSE2,SkipBlanksSSE2};
+#endif
+	return {FindDelimiterScalar,SkipBlanksScalar};
+}
+
+/** @brief Token scanner in use (selected on first call) */
+static TokenScanner const& Scanner()
+{
+	static const TokenScanner S = SelectTokenScanner();
+	return S;
+}
+
+/**
+ * @brief Skips whitespace in a line and increments a position indicator accordingly
+ * @param LineData      Line data being parsed
+ * @param siter         Current position in the line (incremented to skip whitespace)
+ * @returns `true` if whitespace is skipped and input is ready to be parsed
+ * @returns `false` if a comment indicator, null character or the end of the line is encountered
+ */
+static bool SkipStringWhitespace(std::string_view LineData, std::size_t &siter)
+{
+	if (siter < LineData.length())
+		siter += Scanner().SkipBlanks(LineData.data() + siter,LineData.length() - siter);
+	if (siter >= LineData.length() || LineData[siter] == '\0' || LineData[siter] == '#')
+		return false;
+	return true;
+}
+
+/**
+ * @brief Reads a word from a line and increments a position indicator accordingly (terminates on whitespace)
+ * @param LineData      Line data being parsed
+ * @param siter         Current position in the line (incremented to end of word)
+ * @returns View of the value read (excluding whitespace characters); this points into `LineData`
+ */
+static std::string_view ReadValue(std::string_view LineData, std::size_t &siter)
+{
+	std::size_t start = siter;
+	if (siter < LineData.length())
+		siter += Scanner().FindDelimiter(LineData.data() + siter,LineData.length() - siter);
+	return LineData.substr(start, siter - start);
+}
+
+/** @brief A value classified and converted by ParseValue() */
+struct ParsedValue
+{
+	bool HasType = false;           ///<`false` if the text holds nothing to store (e.g. a lone `+`)
+	ValueType Type = ValueType::String; ///<Type decided by the typing rules
+	std::errc Error = std::errc();  ///<Conversion error for numeric types
+	int Int = 0;                    ///<Value if `Type` is ValueType::Int
+	double Double = 0.0;            ///<Value if `Type` is ValueType::Double
+};
+
+/**
+ * @brief Converts the leading number of `Text` like `std::stoi`/`std::stod` (but independent of locale)
+ * @param Text          Text being converted
+ * @param Out           Set to the converted value
+ * @returns `std::errc::invalid_argument` if no number could be read, `std::errc::result_out_of_range` if it does not fit
+ * @note As with `strtol`/`strtod`, a single leading `+` is accepted and
+ * 	anything following the leading number is ignored.
+ */
+template <class T>
+static std::errc ConvertNumber(std::string_view Text, T &Out)
+{
+	const char* first = Text.data();
+	const char* last = Text.data() + Text.length();
+	if (first != last && *first == '+') {
+		first++;
+		if (first != last && (*first == '+' || *first == '-'))
+			return std::errc::invalid_argument;
+	}
+	return std::from_chars(first,last,Out).ec;
+}
+
+/**
+ * @brief Determines what type of information a value contains (string, int, or float) and converts it in the same pass
+ * @param VarVal        Text being classified
+ * @returns The type of the value along with the converted number
+ *
+ * The typing rules are:
+ * - any character other than digits, `+`, `-`, `.` and a single `e`/`E`
+ *   exponent, or a second `.`, makes the value a string;
+ * - otherwise a `.` or an exponent makes it a double (so `1.` is a double);
+ * - otherwise a digit or `-` makes it an int;
+ * - otherwise (e.g. a lone `+`) nothing is stored.
+ *
+ * Plain integers (an optional sign followed by digits) are accumulated while
+ * they are classified, so the bytes are only read once; other numbers are
+ * converted with `std::from_chars`.
+ */
+static ParsedValue ParseValue(std::string_view VarVal)
+{
+	ParsedValue ret;
+	bool Num = false;   //Contains numbers
+	bool Dot = false;   //Contains decimal point (or exponent)
+	bool Exp = false;   //Already categorized as being in exponential form
+	bool Plain = true;  //Optional sign followed by digits only
+	bool Neg = false;
+	bool Overflow = false;
+	std::size_t Digits = 0;
+	unsigned long long Acc = 0;
+	constexpr unsigned long long Limit = static_cast<unsigned long long>(std::numeric_limits<int>::max()) + 1;
+
+	for (std::size_t i{0}; i < VarVal.length(); i++) {
+		char c = VarVal[i];
+		if (c >= '0' && c <= '9') {
+			Num = true;
+			if (Plain) {
+				Digits++;
+				if (!Overflow) {
+					Acc = Acc * 10 + static_cast<unsigned long long>(c - '0');
+					Overflow = Acc > Limit;
+				}
+			}
+		} else if (c == '-' || c == '+') {
+			if (c == '-')
+				Num = true;
+			if (i != 0)
+				Plain = false;
+			Neg = (i == 0 && c == '-');
+		} else if (c == '.' && !Dot) {
+			Dot = true;
+			Plain = false;
+		} else if ((c == 'e' || c == 'E') && !Exp) {
+			Dot = true;
+			Exp = true;
+			Plain = false;
+		} else if (c != ' ') {
+			ret.HasType = true; //String; nothing can override this
+			ret.Type = ValueType::String;
+			return ret;
+		}
+	}
+
+	if (Dot) {
+		ret.HasType = true;
+		ret.Type = ValueType::Double;
+		ret.Error = ConvertNumber(VarVal,ret.Double);
+	} else if (Num) {
+		ret.HasType = true;
+		ret.Type = ValueType::Int;
+		if (Plain && Digits > 0) {
+			if (Overflow || (!Neg && Acc == Limit))
+				ret.Error = std::errc::result_out_of_range;
+			else
+				ret.Int = Neg ? static_cast<int>(-static_cast<long long>(Acc)) : static_cast<int>(Acc);
+		} else {
+			ret.Error = ConvertNumber(VarVal,ret.Int);
+		}
+	}
+	return ret;
+}
+
+/** @brief An array value converted by ParseArray() */
+struct ParsedArray
+{
+	ValueType Type = ValueType::IntArray;
+	std::vector<int> Ints;       ///<Values if `Type` is ValueType::IntArray
+	std::vector<double> Doubles; ///<Values if `Type` is ValueType::DoubleArray
+	std::errc Error = std::errc(); ///<First conversion error
+	std::string_view Bad;        ///<Token that could not be converted
+
+	/** @brief Native representation of the values */
+	std::string_view Bytes() const
+	{
+		if (Type == ValueType::IntArray)
+			return std::string_view(reinterpret_cast<const char*>(Ints.data()),Ints.size() * sizeof(int));
+		return std::string_view(reinterpret_cast<const char*>(Doubles.data()),Doubles.size() * sizeof(double));
+	}
+};
+
+/**
+ * @brief Converts a line of several numbers into an array
+ * @param LineData      Line being parsed
+ * @param siter         Start of the first value
+ * @param Out           Receives the values (its buffers are reused between lines)
+ * @returns `false` if the line holds fewer than two values or any value is
+ * 	not a number; such lines keep their single-value meaning
+ *
+ * Each token is classified and converted by ParseValue() in a single pass.
+ * If any token is a double the array holds doubles, and only the integer
+ * tokens are converted again.
+ */
+static bool ParseArray(std::string_view LineData, std::size_t siter, ParsedArray &Out)
+{
+	static thread_local std::vector<std::string_view> Tokens;
+	Tokens.clear();
+	Out.Ints.clear();
+	Out.Doubles.clear();
+	Out.Error = std::errc();
+	Out.Bad = std::string_view();
+	std::errc IntError = std::errc();
+	std::string_view IntBad;
+	bool AnyDouble = false;
+	while (SkipStringWhitespace(LineData,siter)) {
+		std::string_view Token = ReadValue(LineData,siter);
+		ParsedValue V = ParseValue(Token);
+		if (!V.HasType || V.Type == ValueType::String)
+			return false;
+		if (V.Type == ValueType::Double) {
+			AnyDouble = true;
+			if (V.Error != std::errc() && Out.Error == std::errc()) {
+				Out.Error = V.Error;
+				Out.Bad = Token;
+			}
+		} else if (V.Error != std::errc() && IntError == std::errc()) {
+			IntError = V.Error;
+			IntBad = Token;
+		}
+		Tokens.push_back(Token);
+		Out.Ints.push_back(V.Int);
+		Out.Doubles.push_back(V.Double);
+	}
+	if (Tokens.size() < 2)
+		return false;
+
+	if (!AnyDouble) {
+		Out.Type = ValueType::IntArray;
+		Out.Error = IntError;
+		Out.Bad = IntBad;
+		return true;
+	}
+	//Integer tokens of a double array are converted as doubles (so they cannot overflow)
+	Out.Type = ValueType::DoubleArray;
+	for (std::size_t i = 0; i < Tokens.size(); i++) {
+		if (Tokens[i].find_first_of(".eE") != std::string_view::npos)
+			continue;
+		std::errc e = ConvertNumber(Tokens[i],Out.Doubles[i]);
+		if (e != std::errc() && Out.Error == std::errc()) {
+			Out.Error = e;
+			Out.Bad = Tokens[i];
+		}
+	}
+	return true;
+}
+
+/** @class LineSink
+ * @brief Receives what the parser finds in a configuration, in line order
+ *
+ * The parser only tokenizes and converts; what happens to each value or
+ * directive is up to the sink.  DictSink applies them to a Dict as they are
+ * found, while RecordingSink stores them in a Fragment so that a file can be
+ * parsed ahead of time (e.g. on another thread) and applied later with
+ * exactly the same result.
+ */
+class LineSink
+{
+	public:
+	virtual ~LineSink() = default;
+	/** @brief A `key value` pair; `Text` is the value as written */
+	virtual void Value(std::string_view Name, ParsedValue const &Val, std::string_view Text) = 0;
+	/** @brief A `key value value ...` line of numbers; `Bytes` holds the values in native form */
+	virtual void Array(std::string_view Name, ValueType Type, std::string_view Bytes) = 0;
+	/** @brief An `include` directive */
+	virtual void Include(std::string_view Path, int ln) = 0;
+	/** @brief An `enforce` directive; returns `false` if enforcement fails */
+	virtual bool Enforce(std::string_view Key, std::string_view Val) = 0;
+	/** @brief A `binary` directive; returns `false` if the file cannot be mapped */
+	virtual bool Binary(std::string_view Name, ValueType Type, std::string_view Path, int ln) = 0;
+	/** @brief A `WARNING` directive on line `ln`; `Text` is the rest of the line */
+	virtual void Warning(std::string_view Text, int ln) = 0;
+	/** @brief A debugging or error message about line `ln` (0 if none) and key `Key` (may be empty) */
+	virtual void Message(Severity Level, int ln, std::string_view Key, std::string const &Text) = 0;
+};
+
+/** @brief Outcome of parsing a single line */
+enum class LineStatus {
+	Ok,    ///<Line handled (or skipped); keep reading
+	Break, ///<`BREAK` signal encountered; stop reading
+	Error  ///<Line could not be handled; stop reading and fail
+};
+
+/**
+ * @brief Tokenizes a single line in place and reports it to a sink
+ * @param LineData      Line being parsed (without its trailing newline)
+ * @param ln            Line number
+ * @param Sink          Receiver of the values and directives found
+ * @param Debug         Whether to print debug info
+ * @returns Whether reading should continue, stop, or fail
+ */
+static LineStatus ParseLine(std::string_view LineData, int ln, LineSink &Sink, bool Debug)
+{
+	using std::to_string;
+	std::size_t siter {0};
+	if (Debug) Sink.Message(Severity::Debug,ln,std::string_view(),"(" + to_string(ln) + "): " + std::string(LineData));
+
+	if (!SkipStringWhitespace(LineData,siter))
+		return LineStatus::Ok;
+
+	//Read variable name
+	std::string_view VarName = ReadValue(LineData,siter);
+	if (VarName == "BREAK") { //Stop reading on break signal
+		if (Debug) Sink.Message(Severity::Debug,ln,std::string_view(),"Encountered \"BREAK\" signal.  Terminating input.");
+		return LineStatus::Break;
+	}
+	if (VarName.length() < 1)
+		return LineStatus::Ok;
+	
+	//Read variable value
+	if (!SkipStringWhitespace(LineData,siter)) {
+		Sink.Message(Severity::Error,ln,VarName,"Reached end of line " + to_string(ln) + "while parsing variable: " + std::string(LineData));
+		return LineStatus::Error;
+	}
+	std::size_t ValueStart = siter;
+	std::string_view VarVal = ReadValue(LineData,siter);
+
+	//Include handler
+	if (VarName == "include" || VarName == "INCLUDE") {
+		Sink.Include(VarVal,ln);
+		return LineStatus::Ok;
+	}
+	//Warning handler
+	if (VarName == "WARNING" || VarName == "warning") {
+		std::size_t space = LineData.find(' ');
+		Sink.Warning((space == std::string_view::npos) ? std::string_view() : LineData.substr(space),ln);
+		return LineStatus::Ok;
+	}
+	//Enforcement handler (only handles strings); the enforced value follows a single separator
+	if (VarName == "enforce" || VarName == "ENFORCE") {
+		siter++;
+		std::string_view EnforceVal;
+		if (siter < LineData.length())
+			EnforceVal = ReadValue(LineData,siter);
+		return Sink.Enforce(VarVal,EnforceVal) ? LineStatus::Ok : LineStatus::Error;
+	}
+	//Binary array handler: `binary KEY double|int FILE` maps FILE as the values of KEY
+	if (VarName == "binary" || VarName == "BINARY") {
+		std::string_view TypeName, Path;
+		if (SkipStringWhitespace(LineData,siter))
+			TypeName = ReadValue(LineData,siter);
+		if (SkipStringWhitespace(LineData,siter))
+			Path = ReadValue(LineData,siter);
+		ValueType Type = ValueType::DoubleArray;
+		if (TypeName == "int" || TypeName == "INT")
+			Type = ValueType::IntArray;
+		else if (TypeName != "double" && TypeName != "DOUBLE")
+			Path = std::string_view();
+		if (Path.empty()) {
+			Sink.Message(Severity::Error,ln,VarVal,"Expected \"binary KEY double|int FILE\" on line " + to_string(ln) + ":\n" + std::string(LineData));
+			return LineStatus::Error;
+		}
+		return Sink.Binary(VarVal,Type,Path,ln) ? LineStatus::Ok : LineStatus::Error;
+	}
+
+	//Further numbers on the line make it an array
+	std::size_t Next = siter;
+	if (SkipStringWhitespace(LineData,Next)) {
+		static thread_local ParsedArray Arr;
+		if (ParseArray(LineData,ValueStart,Arr)) {
+			if (Arr.Error != std::errc()) {
+				bool Double = (Arr.Type == ValueType::DoubleArray);
+				if (Arr.Error == std::errc::result_out_of_range) {
+					Sink.Message(Severity::Error,ln,VarName,std::string(Double ? "Double " : "Int ") + std::string(Arr.Bad) + " on line " + to_string(ln) + " is out of range.");
+				} else {
+					Sink.Message(Severity::Error,ln,VarName,"Failed to parse " + std::string(Double ? "double" : "int") + " " + std::string(Arr.Bad) + " on line " + to_string(ln) + ":\n" + std::string(LineData));
+				}
+				return LineStatus::Error;
+			}
+			Sink.Array(VarName,Arr.Type,Arr.Bytes());
+			return LineStatus::Ok;
+		}
+	}
+
+	//Store in dictionary
+	ParsedValue Val = ParseValue(VarVal);
+	if (!Val.HasType)
+		return LineStatus::Ok;
+	if (Val.Type != ValueType::String && Val.Error != std::errc()) {
+		const char* TypeName = (Val.Type == ValueType::Double) ? "double" : "int";
+		if (Val.Error == std::errc::result_out_of_range) {
+			Sink.Message(Severity::Error,ln,VarName,std::string(Val.Type == ValueType::Double ? "Double " : "Int ") + std::string(VarVal) + " on line " + to_string(ln) + " is out of range.");
+		} else {
+			Sink.Message(Severity::Error,ln,VarName,"Failed to parse " + std::string(TypeName) + " " + std::string(VarVal) + " on line " + to_string(ln) + ":\n" + std::string(LineData));
+		}
+		return LineStatus::Error;
+	}
+	Sink.Value(VarName,Val,VarVal);
+	return LineStatus::Ok;
+}
+
+/** @brief Amount of text read by ParseBuffer() or ParseStream(), for Stats */
+struct ParseExtent
+{
+	std::uint64_t Bytes = 0;
+	std::uint64_t Lines = 0;
+};
+
+/**
+ * @brief Parses an in-memory configuration buffer line by line without copying it
+ * @param Data          Entire contents of the configuration
+ * @param Sink          Receiver of the values and directives found
+ * @param Debug         Whether to print debug info
+ * @param FirstLine     Line number of the start of `Data`
+ * @param Stopped       Set to `true` if reading ended at a `BREAK` (may be null)
+ * @param Extent        Set to the amount of text read (may be null)
+ * @return `True` on successful read of config
+ * @return `False` if an error occurs
+ */
+static bool ParseBuffer(std::string_view Data, LineSink &Sink, bool Debug, int FirstLine = 1, bool* Stopped = nullptr, ParseExtent* Extent = nullptr)
+{
+	int ln{FirstLine - 1};
+	std::size_t pos{0};
+	bool ret = true;
+	while (pos < Data.length()) {
+		std::size_t eol = Data.find('\n',pos);
+		if (eol == std::string_view::npos)
+			eol = Data.length();
+		ln += 1;
+		LineStatus status = ParseLine(Data.substr(pos, eol - pos), ln, Sink, Debug);
+		pos = eol + 1;
+		if (status == LineStatus::Break) {
+			if (Stopped) *Stopped = true;
+			break;
+		}
+		if (status == LineStatus::Error) {
+			ret = false;
+			break;
+		}
+	}
+	if (Extent) {
+		Extent->Bytes = std::min(pos,Data.length());
+		Extent->Lines = static_cast<std::uint64_t>(ln - (FirstLine - 1));
+	}
+	return ret;
+}
+
+/**
+ * @brief Parses a configuration stream line by line
+ * @param filename      Name used for the stream in messages
+ * @param f_in          Stream being read
+ * @param Sink          Receiver of the values and directives found
+ * @param Debug         Whether to print debug info
+ * @param Extent        Set to the amount of text read (may be null)
+ * @return `True` on successful read of config
+ * @return `False` if an error occurs
+ */
+static bool ParseStream(const char* filename, std::istream &f_in, LineSink &Sink, bool Debug, ParseExtent* Extent = nullptr)
+{
+	std::string LineData; //Reused between lines to avoid reallocating
+	int ln{0};
+	std::uint64_t Bytes{0};
+	bool ret = true;
+	while (std::getline(f_in,LineData)) {
+		ln += 1;
+		Bytes += LineData.length() + 1;
+		LineStatus status = ParseLine(LineData, ln, Sink, Debug);
+		if (status == LineStatus::Break)
+			break;
+		if (status == LineStatus::Error) {
+			ret = false;
+			break;
+		}
+	}
+	if (Extent) {
+		Extent->Bytes = Bytes;
+		Extent->Lines = static_cast<std::uint64_t>(ln);
+	}
+	if (!ret)
+		return false;
+	if (f_in.bad()) {
+		Sink.Message(Severity::Error,0,std::string_view(),"An error occurred while reading " + std::string(filename) + ".  Failed to load.");
+		return false;
+	}
+	return true;
+}
+
+/** @brief Counts the text read from `Name` in Stats, if they are enabled */
+static void CountParsed(std::string_view Name, ParseExtent const &Extent)
+{
+	if (StatsEnabled())
+		CountFile(Name,[&](FileStats &F) {
+			F.Bytes += Extent.Bytes;
+			F.Lines += Extent.Lines;
+		});
+}
+
+/** @brief Identity of a file on disk, used to detect changes */
+struct FileStamp
+{
+	bool Exists = false;    ///<Whether the file could be found
+	std::uint64_t Size = 0; ///<Size in bytes
+	std::int64_t MTime = 0; ///<Modification time in nanoseconds (0 if unknown)
+	std::uint64_t Device = 0; ///<Device holding the file (0 if unknown)
+	std::uint64_t Inode = 0;  ///<Inode of the file (0 if unknown)
+};
+
+/**
+ * @brief Checks whether two stamps (and names) refer to the same file
+ * @param A             Stamp of the first file
+ * @param AName         Name of the first file
+ * @param B             Stamp of the second file
+ * @param BName         Name of the second file
+ * @return `True` if they share a device and inode or, where those are unknown, a name
+ */
+static bool SameFile(FileStamp const &A, std::string_view AName, FileStamp const &B, std::string_view BName)
+{
+	if (A.Inode != 0 && B.Inode != 0)
+		return A.Device == B.Device && A.Inode == B.Inode;
+	return AName == BName;
+}
+
+#ifdef PARSELI_HAVE_MMAP
+/**
+ * @brief Converts the result of `stat` into a FileStamp
+ * @param st            Status of the file
+ * @return Stamp of the file
+ */
+static FileStamp StampFromStat(struct stat const &st)
+{
+	FileStamp S;
+	S.Exists = true;
+	S.Size = static_cast<std::uint64_t>(st.st_size);
+	S.Device = static_cast<std::uint64_t>(st.st_dev);
+	S.Inode = static_cast<std::uint64_t>(st.st_ino);
+#ifdef __APPLE__
+	S.MTime = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+	S.MTime = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+	return S;
+}
+#endif
+
+/**
+ * @brief Looks up the size and modification time of a file
+ * @param filename      Name of the file
+ * @return Stamp of the file (`Exists` is false if it cannot be found)
+ */
+static FileStamp StampFile(const char* filename)
+{
+#ifdef PARSELI_HAVE_MMAP
+	struct stat st;
+	if (stat(filename,&st) != 0)
+		return FileStamp();
+	return StampFromStat(st);
+#else
+	FileStamp S;
+	std::ifstream f_in(filename,std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+	S.Exists = static_cast<bool>(f_in);
+	if (S.Exists)
+		S.Size = static_cast<std::uint64_t>(f_in.tellg());
+	return S;
+#endif
+}
+
+/** @brief Read-only view of a whole file, memory mapped where possible */
+class MappedFile
+{
+	const char* Data = nullptr;
+	std::size_t Size = 0;
+	bool Mapped = false;
+	FileStamp Stamp;
+	std::string Fallback; ///<Contents for files that cannot be mapped (pipes, devices)
+	public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile()
+	{
+#ifdef PARSELI_HAVE_MMAP
+		if (Mapped)
+			munmap(const_cast<char*>(Data),Size);
+#endif
+	}
+
+	/**
+	 * @param filename      Name of the file to open
+	 * @return `True` if the file could be opened and read
+	 */
+	bool Open(const char* filename)
+	{
+#ifdef PARSELI_HAVE_MMAP
+		int fd = open(filename,O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd,&st) == 0 && S_ISREG(st.st_mode)) {
+			Stamp = StampFromStat(st);
+			Size = static_cast<std::size_t>(st.st_size);
+			if (Size > 0) {
+				void* p = mmap(nullptr,Size,PROT_READ,MAP_PRIVATE,fd,0);
+				if (p != MAP_FAILED) {
+					madvise(p,Size,MADV_SEQUENTIAL);
+					Data = static_cast<const char*>(p);
+					Mapped = true;
+				}
+			}
+			if (Mapped || Size == 0) {
+				close(fd);
+				return true;
+			}
+		}
+		close(fd);
+#endif
+		std::ifstream f_in(filename,std::ifstream::in | std::ifstream::binary);
+		if (!f_in) return false;
+		Fallback.assign(std::istreambuf_iterator<char>(f_in),std::istreambuf_iterator<char>());
+		Data = Fallback.data();
+		Size = Fallback.size();
+		Stamp.Exists = true;
+		Stamp.Size = Size;
+		return true;
+	}
+
+	/** @brief View of the whole file */
+	std::string_view View() const {return std::string_view(Data,Size);}
+	/** @brief Size and modification time of the file when it was opened */
+	FileStamp const& GetStamp() const {return Stamp;}
+};
+
+/** @brief Hashes file contents (used to tell whether a changed file really differs) */
+static std::uint64_t HashContents(std::string_view Data)
+{
+	return static_cast<std::uint64_t>(std::hash<std::string_view>{}(Data));
+}
+
+/** @brief A value or directive recorded by RecordingSink
+ *
+ * Operations hold no pointers: strings are stored as offsets into the text
+ * buffer of their fragment, so a fragment can be copied, written to disk
+ * and replayed straight from a memory mapping.
+ */
+struct FragmentOp
+{
+	/** @brief Which LineSink call was recorded */
+	enum class Kind : unsigned char {Value, Include, Enforce, Warning, Message, Array, Binary};
+	Kind Type;
+	Severity Level;            ///<Severity (Message)
+	std::int32_t Line;         ///<Line number (Include, Binary, Warning, Message)
+	std::uint64_t NameOffset;  ///<Key (Value, Enforce, Array, Binary, Message) or path (Include)
+	std::uint64_t NameLength;
+	std::uint64_t TextOffset;  ///<Value text (Value, Enforce), message (Warning, Message), values (Array) or path (Binary)
+	std::uint64_t TextLength;
+	ParsedValue Val;           ///<Converted value (Value) or type (Array, Binary)
+};
+
+/** @brief Non-owning view of a parsed file, ready to be replayed into a LineSink */
+struct FragmentView
+{
+	std::string_view Filename;      ///<File the fragment was read from
+	bool Opened = false;            ///<Whether the file could be opened at all
+	bool Ok = true;                 ///<Whether parsing finished without an error
+	const FragmentOp* Ops = nullptr; ///<Everything found, in line order
+	std::size_t OpCount = 0;
+	const char* Text = nullptr;     ///<Strings referenced by `Ops`
+	FileStamp Stamp;                ///<Identity of the file (for cycle detection)
+};
+
+/** @brief A parsed file, owning its operations and text */
+struct Fragment
+{
+	std::string Filename;
+	bool Opened = false;
+	bool Ok = true;
+	bool Stopped = false;        ///<Whether reading ended at a `BREAK`
+	FileStamp Stamp;             ///<Identity of the file when it was parsed
+	std::uint64_t Hash = 0;      ///<Hash of the contents (only computed for caching)
+	std::vector<FragmentOp> Ops;
+	std::string Text;
+
+	/** @brief View of the fragment (invalidated if it is modified) */
+	FragmentView View() const
+	{
+		return FragmentView{Filename,Opened,Ok,Ops.data(),Ops.size(),Text.data(),Stamp};
+	}
+};
+
+class IncludePrefetcher;
+
+/** @brief Records everything the parser finds into a Fragment */
+class RecordingSink : public LineSink
+{
+	Fragment &F;
+	IncludePrefetcher* Prefetch; ///<Notified of includes as soon as they are found (may be null)
+	bool Debug;
+
+	/** @brief Appends an operation, copying its strings into the text buffer */
+	FragmentOp& Record(FragmentOp::Kind Type, std::string_view Name, std::string_view Text)
+	{
+		FragmentOp Op{Type,Severity::Debug,0,F.Text.length(),Name.length(),0,Text.length(),ParsedValue()};
+		F.Text.append(Name.data(),Name.length());
+		Op.TextOffset = F.Text.length();
+		F.Text.append(Text.data(),Text.length());
+		return F.Ops.emplace_back(Op);
+	}
+
+	public:
+	RecordingSink(Fragment &F_, IncludePrefetcher* Prefetch_, bool Debug_) : F(F_), Prefetch(Prefetch_), Debug(Debug_) {}
+
+	void Value(std::string_view Name, ParsedValue const &Val, std::string_view Text) override
+	{
+		//Numbers only need their text for debug output
+		bool KeepText = (Val.Type == ValueType::String || Debug);
+		Record(FragmentOp::Kind::Value,Name,KeepText ? Text : std::string_view()).Val = Val;
+	}
+	void Array(std::string_view Name, ValueType Type, std::string_view Bytes) override
+	{
+		FragmentOp &Op = Record(FragmentOp::Kind::Array,Name,Bytes);
+		Op.Val.HasType = true;
+		Op.Val.Type = Type;
+	}
+	void Include(std::string_view Path, int ln) override;
+	bool Enforce(std::string_view Key, std::string_view Val) override
+	{
+		Record(FragmentOp::Kind::Enforce,Key,Val);
+		return true; //Checked when the fragment is replayed
+	}
+	bool Binary(std::string_view Name, ValueType Type, std::string_view Path, int ln) override
+	{
+		FragmentOp &Op = Record(FragmentOp::Kind::Binary,Name,Path);
+		Op.Line = ln;
+		Op.Val.HasType = true;
+		Op.Val.Type = Type;
+		return true; //Mapped when the fragment is replayed
+	}
+	void Warning(std::string_view Text, int ln) override
+	{
+		Record(FragmentOp::Kind::Warning,std::string_view(),Text).Line = ln;
+	}
+	void Message(Severity Level, int ln, std::string_view Key, std::string const &Text) override
+	{
+		FragmentOp &Op = Record(FragmentOp::Kind::Message,Key,Text);
+		Op.Level = Level;
+		Op.Line = ln;
+	}
+};
+
+/**
+ * @brief Feeds a recorded fragment into a sink
+ * @param F             Fragment being replayed
+ * @param Sink          Receiver of the recorded values and directives
+ * @return `False` if an enforcement or a mapping failed or the fragment ended in an error
+ */
+static bool ReplayFragment(FragmentView const &F, LineSink &Sink)
+{
+	for (std::size_t i = 0; i < F.OpCount; i++) {
+		FragmentOp const &Op = F.Ops[i];
+		std::string_view Name(F.Text + Op.NameOffset,Op.NameLength);
+		std::string_view Text(F.Text + Op.TextOffset,Op.TextLength);
+		switch (Op.Type) {
+			case FragmentOp::Kind::Value: Sink.Value(Name,Op.Val,Text); break;
+			case FragmentOp::Kind::Include: Sink.Include(Name,Op.Line); break;
+			case FragmentOp::Kind::Enforce:
+				if (!Sink.Enforce(Name,Text))
+					return false;
+				break;
+			case FragmentOp::Kind::Warning: Sink.Warning(Text,Op.Line); break;
+			case FragmentOp::Kind::Message: Sink.Message(Op.Level,Op.Line,Name,std::string(Text)); break;
+			case FragmentOp::Kind::Array: Sink.Array(Name,Op.Val.Type,Text); break;
+			case FragmentOp::Kind::Binary:
+				if (!Sink.Binary(Name,Op.Val.Type,Text,Op.Line))
+					return false;
+				break;
+		}
+	}
+	return F.Ok;
+}
+
+/**
+ * @brief Parses the contents of a file that has already been read into a fragment
+ * @param filename      Name of the configuration file
+ * @param Data          Contents of the file
+ * @param Stamp         Identity of the file
+ * @param Prefetch      Notified of includes as soon as they are found (may be null)
+ * @param Debug         Whether to record debugging information
+ * @param Hash          Whether to hash the file contents (for caching)
+ * @return Fragment holding the parsed file
+ */
+static Fragment ParseFragment(std::string const &filename, std::string_view Data, FileStamp const &Stamp, IncludePrefetcher* Prefetch, bool Debug, bool Hash)
+{
+	Fragment F;
+	F.Filename = filename;
+	F.Opened = true;
+	F.Stamp = Stamp;
+	if (Hash)
+		F.Hash = HashContents(Data);
+	RecordingSink Sink(F,Prefetch,Debug);
+	if (Debug) Sink.Message(Severity::Debug,0,std::string_view(),"Opened " + filename + " for input");
+	ParseExtent Extent;
+	F.Ok = ParseBuffer(Data,Sink,Debug,1,nullptr,&Extent);
+	CountParsed(filename,Extent);
+	if (F.Ok && Debug) Sink.Message(Severity::Debug,0,std::string_view(),"Completed parsing " + filename);
+	return F;
+}
+
+/**
+ * @brief Reads a file into a fragment
+ * @param filename      Name of the configuration file to read
+ * @param Prefetch      Notified of includes as soon as they are found (may be null)
+ * @param Debug         Whether to record debugging information
+ * @param Hash          Whether to hash the file contents (for caching)
+ * @return Fragment holding the parsed file (`Opened` is false if it could not be read)
+ */
+static Fragment LoadFragment(std::string const &filename, IncludePrefetcher* Prefetch, bool Debug, bool Hash)
+{
+	MappedFile f_in;
+	if (!f_in.Open(filename.c_str())) {
+		Fragment F;
+		F.Filename = filename;
+		return F;
+	}
+	return ParseFragment(filename,f_in.View(),f_in.GetStamp(),Prefetch,Debug,Hash);
+}
+
+/** @class FragmentStore
+ * @brief Parsed files available to `include` directives during a replay
+ */
+class FragmentStore
+{
+	public:
+	virtual ~FragmentStore() = default;
+	/** @brief Finds the fragment of `Path`; returns `false` if it is not available */
+	virtual bool Find(std::string const &Path, FragmentView &Out) const = 0;
+};
+
+/** @brief Device and inode of a file, identifying it under any name */
+using FileKey = std::pair<std::uint64_t,std::uint64_t>;
+
+/** @brief Key of a file that exists (or `nullopt` where inodes are unknown) */
+static std::optional<FileKey> KeyOf(FileStamp const &S)
+{
+	if (!S.Exists || S.Inode == 0)
+		return std::nullopt;
+	return FileKey(S.Device,S.Inode);
+}
+
+/** @class IncludeLoader
+ * @brief Reads included files on demand, parsing each file only once
+ *
+ * A file included more than once (under any name) is parsed the first
+ * time and its fragment replayed afterwards.
+ */
+class IncludeLoader : public FragmentStore
+{
+	mutable std::unordered_map<std::string,std::unique_ptr<Fragment>> Files;
+	mutable std::map<FileKey,Fragment const*> ById;
+	bool Debug;
+	public:
+	explicit IncludeLoader(bool Debug_) : Debug(Debug_) {}
+
+	bool Find(std::string const &Path, FragmentView &Out) const override
+	{
+		std::unique_ptr<Fragment> &Slot = Files[Path];
+		if (!Slot) {
+			std::optional<FileKey> Key = KeyOf(StampFile(Path.c_str()));
+			auto it = Key ? ById.find(*Key) : ById.end();
+			if (it != ById.end()) {
+				Out = it->second->View();
+				return true;
+			}
+			Slot = std::make_unique<Fragment>(LoadFragment(Path,nullptr,Debug,false));
+			if (std::optional<FileKey> Loaded = KeyOf(Slot->Stamp))
+				ById.emplace(*Loaded,Slot.get());
+		}
+		Out = Slot->View();
+		return true;
+	}
+};
+
+/** @class WorkerPool
+ * @brief A fixed set of threads running queued tasks
+ */
+class WorkerPool
+{
+	std::vector<std::thread> Threads;
+	std::deque<std::function<void()>> Tasks;
+	std::mutex PoolMutex;
+	std::condition_variable TaskReady;
+	std::condition_variable AllDone;
+	std::size_t Pending = 0; ///<Tasks queued or running
+	bool Stopping = false;
+
+	/** @brief Runs tasks until the pool is destroyed */
+	void Work()
+	{
+		std::unique_lock<std::mutex> lock(PoolMutex);
+		while (true) {
+			TaskReady.wait(lock,[this]{return Stopping || !Tasks.empty();});
+			if (Tasks.empty())
+				return;
+			std::function<void()> Task = std::move(Tasks.front());
+			Tasks.pop_front();
+			lock.unlock();
+			Task();
+			lock.lock();
+			if (--Pending == 0)
+				AllDone.notify_all();
+		}
+	}
+
+	public:
+	/** @brief Starts `n` threads (at least one) */
+	explicit WorkerPool(unsigned n)
+	{
+		for (unsigned i = 0; i < std::max(n,1u); i++)
+			Threads.emplace_back([this]{Work();});
+	}
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(PoolMutex);
+			Stopping = true;
+		}
+		TaskReady.notify_all();
+		for (std::thread &T : Threads)
+			T.join();
+	}
+
+	/** @brief Queues a task (which may itself submit further tasks) */
+	void Submit(std::function<void()> Task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(PoolMutex);
+			Tasks.push_back(std::move(Task));
+			Pending++;
+		}
+		TaskReady.notify_one();
+	}
+
+	/** @brief Waits until every submitted task has finished */
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(PoolMutex);
+		AllDone.wait(lock,[this]{return Pending == 0;});
+	}
+};
+
+#ifdef PARSELI_HAVE_IO_URING
+/**
+ * @brief Converts the result of `statx` into a FileStamp, as StampFromStat() would
+ * @param st            Status of the file
+ * @return Stamp of the file
+ */
+static FileStamp StampFromStatx(struct statx const &st)
+{
+	FileStamp S;
+	S.Exists = true;
+	S.Size = st.stx_size;
+	S.Device = static_cast<std::uint64_t>(makedev(st.stx_dev_major,st.stx_dev_minor));
+	S.Inode = st.stx_ino;
+	S.MTime = static_cast<std::int64_t>(st.stx_mtime.tv_sec) * 1000000000 + st.stx_mtime.tv_nsec;
+	return S;
+}
+
+/** @class IoRing
+ * @brief A minimal io_uring instance: one submission and one completion queue
+ *
+ * Submission entries are filled and submitted by one thread at a time
+ * (the caller serialises them); completions are reaped by a single thread.
+ */
+class IoRing
+{
+	int Fd = -1;
+	unsigned Entries = 0;
+	void* SqMap = MAP_FAILED;
+	std::size_t SqMapSize = 0;
+	void* CqMap = MAP_FAILED;
+	std::size_t CqMapSize = 0;
+	io_uring_sqe* Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	std::size_t SqesSize = 0;
+	unsigned* SqHead = nullptr;
+	unsigned* SqTail = nullptr;
+	unsigned* SqMask = nullptr;
+	unsigned* SqArray = nullptr;
+	unsigned* CqHead = nullptr;
+	unsigned* CqTail = nullptr;
+	unsigned* CqMask = nullptr;
+	io_uring_cqe* Cqes = nullptr;
+	unsigned Queued = 0; ///<Entries filled since the last Submit()
+
+	/** @brief Address `Offset` bytes into a mapping */
+	template <class T>
+	static T* At(void* Map, unsigned Offset) {return reinterpret_cast<T*>(static_cast<char*>(Map) + Offset);}
+
+	public:
+	/** @brief Sets up a ring of (at least) `n` entries; Valid() is false if the kernel refuses or cannot wait with a timeout */
+	explicit IoRing(unsigned n)
+	{
+		io_uring_params p;
+		std::memset(&p,0,sizeof(p));
+		int fd = static_cast<int>(syscall(__NR_io_uring_setup,n,&p));
+		if (fd < 0)
+			return;
+		Fd = fd;
+		if (!(p.features & IORING_FEAT_EXT_ARG)) {
+			Close();
+			return;
+		}
+		Entries = p.sq_entries;
+		SqMapSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		CqMapSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+		if (p.features & IORING_FEAT_SINGLE_MMAP)
+			SqMapSize = CqMapSize = std::max(SqMapSize,CqMapSize);
+		SqMap = mmap(nullptr,SqMapSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,Fd,IORING_OFF_SQ_RING);
+		if (SqMap == MAP_FAILED) {
+			Close();
+			return;
+		}
+		if (p.features & IORING_FEAT_SINGLE_MMAP)
+			CqMap = SqMap;
+		else if ((CqMap = mmap(nullptr,CqMapSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,Fd,IORING_OFF_CQ_RING)) == MAP_FAILED) {
+			Close();
+			return;
+		}
+		SqesSize = p.sq_entries * sizeof(io_uring_sqe);
+		void* s = mmap(nullptr,SqesSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,Fd,IORING_OFF_SQES);
+		if (s == MAP_FAILED) {
+			Close();
+			return;
+		}
+		Sqes = static_cast<io_uring_sqe*>(s);
+		SqHead = At<unsigned>(SqMap,p.sq_off.head);
+		SqTail = At<unsigned>(SqMap,p.sq_off.tail);
+		SqMask = At<unsigned>(SqMap,p.sq_off.ring_mask);
+		SqArray = At<unsigned>(SqMap,p.sq_off.array);
+		CqHead = At<unsigned>(CqMap,p.cq_off.head);
+		CqTail = At<unsigned>(CqMap,p.cq_off.tail);
+		CqMask = At<unsigned>(CqMap,p.cq_off.ring_mask);
+		Cqes = At<io_uring_cqe>(CqMap,p.cq_off.cqes);
+	}
+	IoRing(const IoRing&) = delete;
+	IoRing& operator=(const IoRing&) = delete;
+	~IoRing() {Close();}
+
+	/** @brief Unmaps the queues and closes the ring */
+	void Close()
+	{
+		if (Sqes != MAP_FAILED)
+			munmap(Sqes,SqesSize);
+		if (CqMap != MAP_FAILED && CqMap != SqMap)
+			munmap(CqMap,CqMapSize);
+		if (SqMap != MAP_FAILED)
+			munmap(SqMap,SqMapSize);
+		Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+		SqMap = CqMap = MAP_FAILED;
+		if (Fd >= 0)
+			close(Fd);
+		Fd = -1;
+	}
+
+	/** @brief Whether the ring could be set up */
+	bool Valid() const {return Fd >= 0;}
+	/** @brief Operations that may be in flight at once */
+	unsigned Size() const {return Entries;}
+
+	/** @brief Clears and returns the next submission entry (at most Size() in flight) */
+	io_uring_sqe& Next()
+	{
+		unsigned Tail = *SqTail + Queued++;
+		unsigned i = Tail & *SqMask;
+		SqArray[i] = i;
+		std::memset(&Sqes[i],0,sizeof(io_uring_sqe));
+		return Sqes[i];
+	}
+
+	/**
+	 * @brief Hands the entries filled since the last call to the kernel
+	 * @param Withdrawn     Called with the `user_data` of each entry the kernel did not take
+	 * @return `False` if the kernel refused some of the entries; those are
+	 * 	taken back out of the ring (and passed to `Withdrawn`), so they never run
+	 */
+	template <class F>
+	bool Submit(F &&Withdrawn)
+	{
+		if (Queued == 0)
+			return true;
+		unsigned Tail = *SqTail + Queued;
+		__atomic_store_n(SqTail,Tail,__ATOMIC_RELEASE);
+		unsigned n = Queued;
+		Queued = 0;
+		while (n > 0) {
+			int r = static_cast<int>(syscall(__NR_io_uring_enter,Fd,n,0,0,nullptr,0));
+			if (r < 0 && errno == EINTR)
+				continue;
+			if (r <= 0) {
+				//Entries from the kernel's head on were not consumed
+				unsigned Head = __atomic_load_n(SqHead,__ATOMIC_ACQUIRE);
+				for (unsigned i = Head; i != Tail; i++)
+					Withdrawn(Sqes[SqArray[i & *SqMask]].user_data);
+				__atomic_store_n(SqTail,Head,__ATOMIC_RELEASE);
+				return false;
+			}
+			n -= static_cast<unsigned>(r);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Waits up to `TimeoutMs` milliseconds for a completion, then passes each one to `Handle`
+	 * @param Handle        Called with the `user_data` and result of each completion
+	 * @param TimeoutMs     Longest wait
+	 * @return `False` if waiting failed (a timeout is not a failure)
+	 */
+	template <class F>
+	bool Reap(F &&Handle, int TimeoutMs)
+	{
+		unsigned Head = *CqHead;
+		if (Head == __atomic_load_n(CqTail,__ATOMIC_ACQUIRE)) {
+			__kernel_timespec Timeout{TimeoutMs / 1000,(TimeoutMs % 1000) * 1000000ll};
+			io_uring_getevents_arg Arg;
+			std::memset(&Arg,0,sizeof(Arg));
+			Arg.ts = reinterpret_cast<std::uint64_t>(&Timeout);
+			int r = static_cast<int>(syscall(__NR_io_uring_enter,Fd,0,1,IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,&Arg,sizeof(Arg)));
+			if (r < 0 && errno != EINTR && errno != ETIME)
+				return false;
+		}
+		unsigned Tail = __atomic_load_n(CqTail,__ATOMIC_ACQUIRE);
+		for (; Head != Tail; Head++) {
+			io_uring_cqe const &C = Cqes[Head & *CqMask];
+			Handle(C.user_data,C.res);
+		}
+		__atomic_store_n(CqHead,Head,__ATOMIC_RELEASE);
+		return true;
+	}
+};
+#endif
+
+/** @class IncludePrefetcher
+ * @brief Parses a file and everything it includes concurrently, into fragments
+ *
+ * Each file is parsed once on the worker pool, and its includes are queued
+ * as soon as the parser reaches them.  Nothing touches a Dict here; the
+ * fragments are applied afterwards in the order the sequential reader
+ * would have read them.
+ *
+ * Where io_uring is available (and asked for), files are opened and read
+ * through a ring instead of on the pool, so the latency of many opens and
+ * reads overlaps while the pool threads only parse.  A file the ring
+ * cannot read (e.g. a pipe, or an error) is read on the pool as before.
+ * If the ring itself fails, every read still queued or in flight is
+ * handed to the pool and the ring is not used again.
+ */
+class IncludePrefetcher : public FragmentStore
+{
+	WorkerPool Pool;
+	mutable std::mutex FilesMutex;
+	std::vector<std::unique_ptr<Fragment>> Owned;
+	std::unordered_map<std::string,Fragment*> Files;
+	std::map<FileKey,Fragment*> ById; ///<Files already queued, under whichever name came first
+	bool Debug;
+	bool Hash; ///<Whether file contents are hashed (for caching)
+	std::mutex PendingMutex;
+	std::condition_variable AllParsed;
+	std::size_t Pending = 0; ///<Files requested but not yet parsed
+
+	/** @brief Marks a requested file as parsed */
+	void Finished()
+	{
+		std::lock_guard<std::mutex> lock(PendingMutex);
+		if (--Pending == 0)
+			AllParsed.notify_all();
+	}
+
+	/**
+	 * @brief Records that `Path` (now stamped) is to be parsed into `F`, unless its file already is under another name
+	 * @return `False` if `Path` now refers to the fragment of that other name (and `F` is not needed)
+	 */
+	bool Claim(std::string const &Path, Fragment* F, FileStamp const &Stamp)
+	{
+		std::optional<FileKey> Key = KeyOf(Stamp);
+		if (!Key)
+			return true;
+		std::lock_guard<std::mutex> lock(FilesMutex);
+		auto [it, Added] = ById.emplace(*Key,F);
+		if (Added || it->second == F)
+			return true;
+		Files[Path] = it->second;
+		return false;
+	}
+
+	/** @brief Stamps, reads and parses `Path` into `F` on the pool */
+	void LoadOnPool(Fragment* F, std::string Path)
+	{
+		Pool.Submit([this,F,Path = std::move(Path)]{
+			if (Claim(Path,F,StampFile(Path.c_str())))
+				*F = LoadFragment(Path,this,Debug,Hash);
+			Finished();
+		});
+	}
+
+#ifdef PARSELI_HAVE_IO_URING
+	/** @brief A file being opened, stamped and read through the ring */
+	struct RingRead
+	{
+		std::string Path;
+		Fragment* F;
+		int Fd = -1;
+		struct statx Status{}; ///<Filled by the `statx` of the open descriptor
+		FileStamp Stamp{};      ///<From `Status` (`Exists` is false until then)
+		std::string Data{};
+		std::size_t Done = 0; ///<Bytes read so far
+	};
+	std::unique_ptr<IoRing> Ring;
+	std::thread Reaper;
+	std::atomic<bool> StopReaper{false};
+	std::mutex RingMutex;
+	std::deque<RingRead*> Ready; ///<Reads whose next operation is waiting for room in the ring
+	std::unordered_set<RingRead*> InFlight; ///<Reads with an operation in the ring
+	bool RingFailed = false; ///<Whether the ring failed (nothing more is read through it)
+
+	/** @brief Longest wait of the reaper before it checks whether to stop */
+	static constexpr int ReapTimeoutMs = 100;
+
+	/** @brief Reads `R` on the pool instead (caller must hold RingMutex; `R` must not be in the ring) */
+	void ReadOnPool(RingRead* R)
+	{
+		if (R->Fd >= 0)
+			close(R->Fd);
+		LoadOnPool(R->F,std::move(R->Path));
+		delete R;
+	}
+
+	/** @brief Stops using the ring, handing every queued read to the pool (caller must hold RingMutex) */
+	void FailRing(const char* What)
+	{
+		if (!RingFailed && Debug) Diagnose(Severity::Debug,std::string_view(),0,std::string_view(),[&]{return std::string("io_uring ") + What + " failed; reading files on the include threads";});
+		RingFailed = true;
+		for (RingRead* R : Ready)
+			ReadOnPool(R);
+		Ready.clear();
+	}
+
+	/** @brief Queues the next operation of each ready read, as far as the ring has room (caller must hold RingMutex) */
+	void Pump()
+	{
+		if (RingFailed) { //Reads that were still in the ring when it failed
+			FailRing("ring");
+			return;
+		}
+		while (!Ready.empty() && InFlight.size() < Ring->Size()) {
+			RingRead* R = Ready.front();
+			Ready.pop_front();
+			io_uring_sqe &E = Ring->Next();
+			if (R->Fd < 0) {
+				E.opcode = IORING_OP_OPENAT;
+				E.fd = AT_FDCWD;
+				E.addr = reinterpret_cast<std::uint64_t>(R->Path.c_str());
+				E.open_flags = O_RDONLY | O_CLOEXEC | O_NONBLOCK; //A pipe must not wait for a writer before it is handed to the pool
+			}
+			else if (!R->Stamp.Exists) {
+				E.opcode = IORING_OP_STATX;
+				E.fd = R->Fd;
+				E.addr = reinterpret_cast<std::uint64_t>(""); //With AT_EMPTY_PATH: the descriptor itself
+				E.len = STATX_BASIC_STATS;
+				E.off = reinterpret_cast<std::uint64_t>(&R->Status);
+				E.statx_flags = AT_EMPTY_PATH;
+			}
+			else {
+				E.opcode = IORING_OP_READ;
+				E.fd = R->Fd;
+				E.addr = reinterpret_cast<std::uint64_t>(R->Data.data() + R->Done);
+				E.len = static_cast<unsigned>(std::min<std::size_t>(R->Data.size() - R->Done,1u << 30));
+				E.off = R->Done;
+			}
+			E.user_data = reinterpret_cast<std::uint64_t>(R);
+			InFlight.insert(R);
+		}
+		std::vector<RingRead*> Withdrawn;
+		if (!Ring->Submit([&](std::uint64_t Data){Withdrawn.push_back(reinterpret_cast<RingRead*>(Data));})) {
+			//Reads the kernel took still complete through the reaper, and go to the pool from there
+			for (RingRead* R : Withdrawn) {
+				InFlight.erase(R);
+				ReadOnPool(R);
+			}
+			FailRing("submission");
+		}
+	}
+
+	/** @brief Advances a read by the result `res` of its last operation */
+	void Step(RingRead* R, int res)
+	{
+		bool Failed = (res < 0);
+		if (!Failed && R->Fd < 0) {
+			R->Fd = res;
+		}
+		else if (!Failed && !R->Stamp.Exists) {
+			//Empty files may be pipes or devices, which are read as streams on the pool
+			Failed = !S_ISREG(R->Status.stx_mode) || R->Status.stx_size == 0;
+			if (!Failed) {
+				R->Stamp = StampFromStatx(R->Status);
+				if (!Claim(R->Path,R->F,R->Stamp)) {
+					close(R->Fd);
+					delete R;
+					Finished();
+					return;
+				}
+				R->Data.resize(static_cast<std::size_t>(R->Stamp.Size));
+			}
+		}
+		else if (!Failed) {
+			R->Done += static_cast<std::size_t>(res);
+			if (res == 0 || R->Done == R->Data.size()) {
+				//Like a mapping, the file ends where it ended when it was stamped
+				close(R->Fd);
+				R->Data.resize(R->Done);
+				Pool.Submit([this,R]{
+					*R->F = ParseFragment(R->Path,R->Data,R->Stamp,this,Debug,Hash);
+					delete R;
+					Finished();
+				});
+				return;
+			}
+		}
+		std::lock_guard<std::mutex> lock(RingMutex);
+		if (Failed)
+			ReadOnPool(R);
+		else
+			Ready.push_back(R);
+	}
+
+	/**
+	 * @brief Handles completions until the prefetcher is destroyed
+	 *
+	 * If waiting fails, the reads still in the ring are read again on the
+	 * pool.  Their buffers are left allocated, since the kernel may yet
+	 * complete an operation into them.
+	 */
+	void Reap()
+	{
+		std::vector<std::pair<RingRead*,int>> Done;
+		while (!StopReaper.load(std::memory_order_acquire)) {
+			Done.clear();
+			bool Ok = Ring->Reap([&](std::uint64_t Data, int res){
+				if (Data != 0) //The wake-up sent by the destructor carries no read
+					Done.emplace_back(reinterpret_cast<RingRead*>(Data),res);
+			},ReapTimeoutMs);
+			if (!Ok) {
+				std::lock_guard<std::mutex> lock(RingMutex);
+				for (RingRead* R : InFlight)
+					LoadOnPool(R->F,R->Path); //Its descriptor stays open for the same reason
+				InFlight.clear();
+				FailRing("wait");
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock(RingMutex);
+				for (auto const &D : Done)
+					InFlight.erase(D.first);
+			}
+			for (auto const &[R,res] : Done)
+				Step(R,res);
+			std::lock_guard<std::mutex> lock(RingMutex);
+			Pump();
+		}
+	}
+#endif
+
+	public:
+	/**
+	 * @param Threads       Threads parsing files (at least one)
+	 * @param Debug_        Whether to record debugging information
+	 * @param Hash_         Whether file contents are hashed (for caching)
+	 * @param UseRing       Whether to read files through io_uring, where the system allows it
+	 */
+	IncludePrefetcher(unsigned Threads, bool Debug_, bool Hash_ = false, bool UseRing = false) : Pool(Threads), Debug(Debug_), Hash(Hash_)
+	{
+#ifdef PARSELI_HAVE_IO_URING
+		if (UseRing) {
+			Ring = std::make_unique<IoRing>(64);
+			if (Ring->Valid())
+				Reaper = std::thread([this]{Reap();});
+			else
+				Ring.reset();
+		}
+#else
+		(void)UseRing;
+#endif
+	}
+	IncludePrefetcher(const IncludePrefetcher&) = delete;
+	IncludePrefetcher& operator=(const IncludePrefetcher&) = delete;
+	~IncludePrefetcher()
+	{
+		Wait();
+#ifdef PARSELI_HAVE_IO_URING
+		if (Ring) {
+			StopReaper.store(true,std::memory_order_release);
+			{
+				//Wakes the reaper now rather than at its next timeout
+				std::lock_guard<std::mutex> lock(RingMutex);
+				if (!RingFailed) {
+					Ring->Next().opcode = IORING_OP_NOP;
+					Ring->Submit([](std::uint64_t){});
+				}
+			}
+			Reaper.join();
+		}
+#endif
+	}
+
+	/** @brief Whether files are read through io_uring */
+	bool UsesRing() const
+	{
+#ifdef PARSELI_HAVE_IO_URING
+		return Ring != nullptr;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	 * @brief Queues `Path` for parsing unless it (under any name) has been queued already
+	 *
+	 * Nothing is read on the calling thread: the file is opened and stamped
+	 * with the read, in the ring or on the pool, and a file that turns out
+	 * to have been queued under another name is then parsed only once.
+	 */
+	void Request(std::string const &Path)
+	{
+		Fragment* F;
+		{
+			std::lock_guard<std::mutex> lock(FilesMutex);
+			Fragment* &Slot = Files[Path];
+			if (Slot)
+				return;
+			F = Slot = Owned.emplace_back(std::make_unique<Fragment>()).get();
+		}
+		{
+			std::lock_guard<std::mutex> lock(PendingMutex);
+			Pending++;
+		}
+#ifdef PARSELI_HAVE_IO_URING
+		if (Ring) {
+			std::lock_guard<std::mutex> lock(RingMutex);
+			if (!RingFailed) {
+				Ready.push_back(new RingRead{Path,F});
+				Pump();
+				return;
+			}
+		}
+#endif
+		LoadOnPool(F,Path);
+	}
+
+	/** @brief Waits until every requested file has been parsed */
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(PendingMutex);
+		AllParsed.wait(lock,[this]{return Pending == 0;});
+	}
+
+	bool Find(std::string const &Path, FragmentView &Out) const override
+	{
+		std::lock_guard<std::mutex> lock(FilesMutex);
+		auto it = Files.find(Path);
+		if (it == Files.end())
+			return false;
+		Out = it->second->View();
+		return true;
+	}
+
+	/** @brief Every requested name and its parsed file (only valid after Wait()) */
+	std::unordered_map<std::string,Fragment*> const& Parsed() const {return Files;}
+};
+
+//Record an include and start parsing the included file straight away
+void RecordingSink::Include(std::string_view Path, int ln)
+{
+	Record(FragmentOp::Kind::Include,Path,std::string_view()).Line = ln;
+	if (Prefetch && Path != F.Filename) //Self-inclusion is rejected when replayed
+		Prefetch->Request(std::string(Path));
+}
+
+/** @brief Files currently being applied, outermost first (for cycle detection) */
+struct IncludeChain
+{
+	struct Entry
+	{
+		FileStamp Stamp;
+		std::string_view Name; ///<Name the file was included by
+	};
+	std::vector<Entry> Files;
+
+	/** @brief Position of the file in the chain, or `npos` if it is not being applied */
+	std::size_t Find(FileStamp const &Stamp, std::string_view Name) const
+	{
+		for (std::size_t i = 0; i < Files.size(); i++)
+			if (SameFile(Files[i].Stamp,Files[i].Name,Stamp,Name))
+				return i;
+		return npos;
+	}
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+};
+
+template <class Target>
+static bool ApplyFragment(FragmentView const &F, std::string_view Name, Target* D, FragmentStore const &Store, IncludeChain &Chain, bool Debug);
+
+/**
+ * @brief Views the values recorded in `Bytes`
+ * @param Bytes         Values in native form (e.g. from a recorded fragment)
+ * @param Scratch       Holds a copy if `Bytes` is not suitably aligned
+ * @return The values, without copying them where possible
+ */
+template <class T>
+static Span<const T> AlignedValues(std::string_view Bytes, std::vector<T> &Scratch)
+{
+	std::size_t n = Bytes.size() / sizeof(T);
+	if (reinterpret_cast<std::uintptr_t>(Bytes.data()) % alignof(T) == 0)
+		return Span<const T>(reinterpret_cast<const T*>(Bytes.data()),n);
+	Scratch.resize(n);
+	std::memcpy(Scratch.data(),Bytes.data(),n * sizeof(T));
+	return Span<const T>(Scratch.data(),n);
+}
+
+/**
+ * @brief Stores a value read from `File` in a Dict (the first value of a key wins)
+ * @return Whether the value was stored
+ */
+template <class V>
+static bool StoreValue(Dict* D, std::string_view /*File*/, std::string_view Name, V const &val, std::string_view /*Text*/ = std::string_view())
+{
+	return D->add(Name,val);
+}
+
+/** @class BindingTarget
+ * @brief Offers the values of a read to a SchemaBinding instead of storing them in a Dict
+ *
+ * Keys that no field binds are reported as warnings; values that do not
+ * fit their field are reported as errors and fail the read, once the whole
+ * configuration has been read.
+ */
+class BindingTarget
+{
+	SchemaBinding &B;
+	public:
+	std::string Filename;
+	bool Mismatched = false; ///<Whether any value did not fit its field
+
+	explicit BindingTarget(SchemaBinding &B_) : B(B_) {}
+
+	/** @brief Offers `V` to the binding, reporting keys and values it rejects */
+	bool Bind(std::string_view File, std::string_view Name, BoundValue const &V)
+	{
+		switch (B.Bind(Name,V)) {
+			case BindResult::Stored:
+				return true;
+			case BindResult::Duplicate:
+				break;
+			case BindResult::Unknown:
+				Diagnose(Severity::Warning,File,0,Name,[&]{return " Unknown key " + std::string(Name) + " in " + std::string(File) + " ignored";});
+				break;
+			case BindResult::Mismatch:
+				Mismatched = true;
+				Diagnose(Severity::Error,File,0,Name,[&]{return "Value of " + std::string(Name) + " in " + std::string(File) + " does not match the type of its field";});
+				break;
+		}
+		return false;
+	}
+
+	/** @brief String bound to `key`, for `enforce` */
+	std::optional<std::string> TryGetString(std::string_view key) const {return B.BoundString(key);}
+};
+
+/** @brief Offers a string read from `File` to a SchemaBinding */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, std::string_view val)
+{
+	BoundValue V;
+	V.Type = ValueType::String;
+	V.Text = val;
+	V.Bool = ParseBool(val);
+	return T->Bind(File,Name,V);
+}
+
+/** @overload */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, int val, std::string_view Text)
+{
+	BoundValue V;
+	V.Type = ValueType::Int;
+	V.Int = val;
+	V.Text = Text;
+	return T->Bind(File,Name,V);
+}
+
+/** @overload */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, double val, std::string_view Text)
+{
+	BoundValue V;
+	V.Type = ValueType::Double;
+	V.Double = val;
+	V.Text = Text;
+	return T->Bind(File,Name,V);
+}
+
+/** @overload */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, Span<const int> val)
+{
+	BoundValue V;
+	V.Type = ValueType::IntArray;
+	V.Ints = val;
+	return T->Bind(File,Name,V);
+}
+
+/** @overload */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, Span<const double> val)
+{
+	BoundValue V;
+	V.Type = ValueType::DoubleArray;
+	V.Doubles = val;
+	return T->Bind(File,Name,V);
+}
+
+/** @overload (the values are copied into the field, so the file is not kept mapped) */
+static bool StoreValue(BindingTarget* T, std::string_view File, std::string_view Name, MappedArray const &val)
+{
+	if (val.GetType() == ValueType::IntArray)
+		return StoreValue(T,File,Name,val.Ints());
+	return StoreValue(T,File,Name,val.Doubles());
+}
+
+/** @brief Applies everything the parser finds to a Dict (or a BindingTarget) */
+template <class Target>
+class DictSink : public LineSink
+{
+	Target* D;
+	std::string_view Filename;  ///<File being applied (for messages and self-inclusion)
+	FragmentStore const &Store; ///<Parsed includes
+	IncludeChain &Chain;        ///<Files being applied, ending with this one
+	bool Debug;
+	StatTimer Timer;            ///<Time spent on the file, for Stats
+	std::uint64_t Entries[6] = {0,0,0,0,0,0}; ///<Values stored, by ValueType
+
+	//Counts a value stored by the file
+	void Stored(bool added, ValueType type)
+	{
+		if (added)
+			Entries[static_cast<std::size_t>(type)] += 1;
+	}
+	public:
+	DictSink(Target* D_, std::string_view Filename_, FragmentStore const &Store_, IncludeChain &Chain_, bool Debug_) :
+		D(D_), Filename(Filename_), Store(Store_), Chain(Chain_), Debug(Debug_) {}
+	DictSink(DictSink const&) = delete;
+	DictSink& operator=(DictSink const&) = delete;
+
+	//Counts the read in Stats once the file has been applied
+	~DictSink() override
+	{
+		if (Timer)
+			CountFile(Filename,[&](FileStats &F) {
+				F.Reads += 1;
+				F.Seconds += Timer.Seconds();
+				for (std::size_t t = 0; t < 6; t++)
+					F.Entries[t] += Entries[t];
+			});
+	}
+
+	void Value(std::string_view Name, ParsedValue const &Val, std::string_view Text) override
+	{
+		switch (Val.Type) {
+			case ValueType::String:
+				Stored(StoreValue(D,Filename,Name,Text),ValueType::String);
+				if (Debug) Diagnose(Severity::Debug,Filename,0,Name,[&]{return "String added: " + std::string(Name) + ": " + std::string(Text);});
+				break;
+			case ValueType::Double:
+				Stored(StoreValue(D,Filename,Name,Val.Double,Text),ValueType::Double);
+				if (Debug) Diagnose(Severity::Debug,Filename,0,Name,[&]{return "Float added: " + std::string(Name) + ": " + std::string(Text);});
+				break;
+			case ValueType::Int:
+				Stored(StoreValue(D,Filename,Name,Val.Int,Text),ValueType::Int);
+				if (Debug) Diagnose(Severity::Debug,Filename,0,Name,[&]{return "Int added: " + std::string(Name) + ": " + std::string(Text);});
+				break;
+			case ValueType::IntArray:
+			case ValueType::DoubleArray:
+				break; //Reported through Array()
+		}
+	}
+
+	void Array(std::string_view Name, ValueType Type, std::string_view Bytes) override
+	{
+		if (Type == ValueType::IntArray) {
+			static thread_local std::vector<int> Scratch;
+			Span<const int> Values = AlignedValues(Bytes,Scratch);
+			Stored(StoreValue(D,Filename,Name,Values),ValueType::IntArray);
+			if (Debug) Diagnose(Severity::Debug,Filename,0,Name,[&]{return "Int array added: " + std::string(Name) + ": " + std::to_string(Values.size()) + " values";});
+		} else {
+			static thread_local std::vector<double> Scratch;
+			Span<const double> Values = AlignedValues(Bytes,Scratch);
+			Stored(StoreValue(D,Filename,Name,Values),ValueType::DoubleArray);
+			if (Debug) Diagnose(Severity::Debug,Filename,0,Name,[&]{return "Double array added: " + std::string(Name) + ": " + std::to_string(Values.size()) + " values";});
+		}
+	}
+
+	//Include handler: a file that is already being applied is rejected along with the include chain
+	void Include(std::string_view Path, int ln) override
+	{
+		if (Path == Filename) {
+			Diagnose(Severity::Error,Filename,ln,std::string_view(),[&]{return "Error in file include: Filename " + std::string(Path) + " cannot include itself (line " + std::to_string(ln) + ")";});
+			return;
+		}
+		std::string IncludeFile(Path);
+		FragmentView F;
+		StatTimer Found; //Read sequentially, the file is parsed by Find()
+		if (!Store.Find(IncludeFile,F) || !F.Opened)
+			return;
+		if (Found)
+			CountFile(IncludeFile,[&](FileStats &S) {S.Seconds += Found.Seconds();});
+		std::size_t Cycle = Chain.Find(F.Stamp,Path);
+		if (Cycle != IncludeChain::npos) {
+			Diagnose(Severity::Error,Filename,ln,std::string_view(),[&]{
+				std::string Text = "Error in file include: include cycle ";
+				for (std::size_t i = Cycle; i < Chain.Files.size(); i++)
+					Text += std::string(Chain.Files[i].Name) + " -> ";
+				return Text + std::string(Path) + " (line " + std::to_string(ln) + " of " + std::string(Filename) + ")";
+			});
+			return;
+		}
+		ApplyFragment(F,IncludeFile,D,Store,Chain,Debug);
+	}
+
+	//Enforcement only checks that the variable has not been differently defined before
+	bool Enforce(std::string_view Key, std::string_view Val) override
+	{
+		if (std::optional<std::string> Enforced = D->TryGetString(Key)) { //If enforcing a value, check if it is identical
+			if (Val.compare(*Enforced) != 0) {
+				Diagnose(Severity::Error,Filename,0,Key,[&]{
+					return "Error enforcing " + std::string(Key) + " in filename " + std::string(Filename) + ": value mismatch (" + std::string(Val) + " vs " + *Enforced + ")";
+				});
+				return false;
+			}
+		} else {
+			Stored(StoreValue(D,Filename,Key,Val),ValueType::String);
+		}
+		return true;
+	}
+
+	//Binary array handler: the file is mapped rather than read, so its values are never parsed or copied
+	bool Binary(std::string_view Name, ValueType Type, std::string_view Path, int ln) override
+	{
+		const char* TypeName = (Type == ValueType::IntArray) ? "int" : "double";
+		MappedArray Values;
+		if (!Values.Open(std::string(Path).c_str(),Type)) {
+			Diagnose(Severity::Error,Filename,ln,Name,[&]{
+				return "Error mapping " + std::string(Path) + " (line " + std::to_string(ln) + " of " + std::string(Filename) + "): the file cannot be read or does not hold a whole number of " + TypeName + " values";
+			});
+			return false;
+		}
+		Stored(StoreValue(D,Filename,Name,Values),Type);
+		if (Debug) Diagnose(Severity::Debug,Filename,ln,Name,[&]{return "Mapped " + std::string(TypeName) + " array: " + std::string(Name) + ": " + std::to_string(Values.size()) + " values from " + std::string(Path);});
+		return true;
+	}
+
+	void Warning(std::string_view Text, int ln) override
+	{
+		Diagnose(Severity::Warning,Filename,ln,std::string_view(),[&]{return std::string(Text);});
+	}
+
+	void Message(Severity Level, int ln, std::string_view Key, std::string const &Text) override
+	{
+		Diagnose(Level,Filename,ln,Key,[&]{return Text;});
+	}
+};
+
+/**
+ * @brief Reads a configuration file straight into a Dict
+ * @param filename      Name of the configuration file to read
+ * @param D             Dictionary where information is loaded to
+ * @param Debug         Whether to print debugging information
+ * @return `True` on successful read of config file
+ */
+template <class Target>
+static bool ReadFile(const char* filename, Target* D, bool Debug)
+{
+	MappedFile f_in;
+	if (!f_in.Open(filename)) return false;
+	if (Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Opened " + std::string(filename) + " for input";});
+
+	IncludeLoader Includes(Debug);
+	IncludeChain Chain;
+	Chain.Files.push_back({f_in.GetStamp(),filename});
+	DictSink<Target> Sink(D,filename,Includes,Chain,Debug);
+	ParseExtent Extent;
+	bool ret = ParseBuffer(f_in.View(),Sink,Debug,1,nullptr,&Extent);
+	CountParsed(filename,Extent);
+	D->Filename = std::string(filename);
+
+	if (ret && Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Completed parsing " + std::string(filename);});
+	return ret;
+}
+
+/**
+ * @brief Applies a parsed file to a Dict, as ReadFile() would have
+ * @param F             Fragment of the file
+ * @param Name          Name the file was read or included by
+ * @param D             Dictionary where information is loaded to
+ * @param Store         Fragments of the files it includes
+ * @param Chain         Files already being applied (`F` is added while it is)
+ * @param Debug         Whether to print debugging information
+ * @return `True` on successful read of config file
+ */
+template <class Target>
+static bool ApplyFragment(FragmentView const &F, std::string_view Name, Target* D, FragmentStore const &Store, IncludeChain &Chain, bool Debug)
+{
+	if (!F.Opened) return false;
+	Chain.Files.push_back({F.Stamp,Name});
+	DictSink<Target> Sink(D,Name,Store,Chain,Debug);
+	bool ret = ReplayFragment(F,Sink);
+	Chain.Files.pop_back();
+	D->Filename = std::string(Name);
+	return ret;
+}
+
+/** @brief Smallest chunk worth parsing on its own thread */
+static constexpr std::size_t MinChunkSize = 256 * 1024;
+
+/**
+ * @brief Parses a buffer in chunks on several threads and applies it in line order
+ * @param Data          Entire contents of the configuration
+ * @param filename      Name of the configuration (for messages)
+ * @param Stamp         Identity of the file (for cycle detection)
+ * @param D             Dictionary where information is loaded to
+ * @param Options       Thread counts and debug flag
+ * @return `True` on successful read of config
+ *
+ * The buffer is split at newlines into a few chunks per thread.  Each chunk
+ * is tokenized and classified into its own fragment, and the fragments are
+ * replayed into `D` in order as soon as each is ready, so the first `add`
+ * still wins, directives act where they occur and nothing after the first
+ * `BREAK` or error is applied.
+ */
+template <class Target>
+static bool ParseChunked(std::string_view Data, std::string_view filename, FileStamp const &Stamp, Target* D, ReadOptions const &Options)
+{
+	bool Debug = Options.Debug;
+	std::size_t Count = std::min<std::size_t>(std::max(Options.ParseThreads,1u) * 4,Data.length() / MinChunkSize);
+	Count = std::max<std::size_t>(Count,1);
+
+	//Chunk boundaries, each just after a newline
+	std::vector<std::size_t> Start(Count + 1,Data.length());
+	Start[0] = 0;
+	for (std::size_t i = 1; i < Count; i++) {
+		std::size_t pos = std::max(Start[i - 1],Data.length() / Count * i);
+		std::size_t eol = (pos < Data.length()) ? Data.find('\n',pos) : std::string_view::npos;
+		Start[i] = (eol == std::string_view::npos) ? Data.length() : eol + 1;
+	}
+
+	WorkerPool Pool(Options.ParseThreads);
+	//Line numbers are needed while parsing, so count each chunk's lines first
+	std::vector<int> FirstLine(Count + 1,1);
+	for (std::size_t i = 0; i < Count; i++)
+		Pool.Submit([&,i]{
+			FirstLine[i + 1] = static_cast<int>(std::count(Data.begin() + Start[i],Data.begin() + Start[i + 1],'\n'));
+		});
+	Pool.Wait();
+	for (std::size_t i = 1; i <= Count; i++)
+		FirstLine[i] += FirstLine[i - 1];
+
+	std::unique_ptr<IncludePrefetcher> Prefetch;
+	if (Options.IncludeThreads > 0)
+		Prefetch = std::make_unique<IncludePrefetcher>(Options.IncludeThreads,Debug,false,Options.IoUring);
+	IncludeLoader Loader(Debug);
+	FragmentStore const &Store = Prefetch ? static_cast<FragmentStore const&>(*Prefetch) : Loader;
+	IncludeChain Chain;
+	Chain.Files.push_back({Stamp,filename});
+	DictSink<Target> Sink(D,filename,Store,Chain,Debug);
+	std::vector<Fragment> Chunks(Count);
+	std::vector<ParseExtent> Extents(Count);
+	std::vector<std::promise<void>> Done(Count);
+	std::atomic<bool> Cancel{false};
+	for (std::size_t i = 0; i < Count; i++)
+		Pool.Submit([&,i]{
+			if (!Cancel.load(std::memory_order_relaxed)) {
+				Fragment &F = Chunks[i];
+				F.Filename = std::string(filename);
+				F.Opened = true;
+				RecordingSink Recorder(F,Prefetch.get(),Debug);
+				F.Ok = ParseBuffer(Data.substr(Start[i],Start[i + 1] - Start[i]),Recorder,Debug,FirstLine[i],&F.Stopped,&Extents[i]);
+			}
+			Done[i].set_value();
+		});
+
+	//Includes parsed by the prefetcher must all be complete before replaying
+	if (Prefetch) {
+		Pool.Wait();
+		Prefetch->Wait();
+	}
+	bool ret = true;
+	for (std::size_t i = 0; i < Count; i++) {
+		Done[i].get_future().wait();
+		ret = ReplayFragment(Chunks[i].View(),Sink);
+		bool Stopped = Chunks[i].Stopped;
+		Chunks[i] = Fragment(); //Release each chunk once applied
+		if (!ret || Stopped) {
+			Cancel.store(true,std::memory_order_relaxed);
+			break;
+		}
+	}
+	Pool.Wait();
+	ParseExtent Total;
+	for (ParseExtent const &E : Extents) {
+		Total.Bytes += E.Bytes;
+		Total.Lines += E.Lines;
+	}
+	CountParsed(filename,Total);
+	return ret;
+}
+
+/*
+	Parsed-configuration cache
+
+	A cache image holds the fragments of a file and of everything it
+	included, along with the size, modification time and content hash of
+	each of those files.  As long as none of them changed, the image is
+	mapped in one go and its fragments are replayed in place, which gives
+	exactly the result of parsing the files again.
+
+	Layout (all sections 8-byte aligned, native byte order):
+		CacheHeader, working directory
+		per file: CacheFileRecord, path, FragmentOp[OpCount], text
+*/
+
+/** @brief Start of a cache image */
+struct CacheHeader
+{
+	char Magic[8];             ///<"PLCACHE" followed by a format version
+	std::uint32_t OpSize;      ///<`sizeof(FragmentOp)`, guarding against layout changes
+	std::uint32_t Debug;       ///<Whether debug messages were recorded
+	std::uint64_t CwdLength;   ///<Length of the working directory includes were resolved in
+	std::uint64_t FileCount;   ///<Number of file records
+};
+
+/** @brief A file in a cache image */
+struct CacheFileRecord
+{
+	std::uint64_t PathLength;
+	std::uint64_t Size;        ///<FileStamp::Size
+	std::int64_t MTime;        ///<FileStamp::MTime
+	std::uint64_t Hash;        ///<Hash of the contents
+	std::uint64_t OpCount;
+	std::uint64_t TextLength;
+	std::uint32_t Opened;      ///<Whether the file existed (a missing include is recorded too)
+	std::uint32_t Ok;          ///<Whether parsing finished without an error
+};
+
+static constexpr char CacheMagic[8] = {'P','L','C','A','C','H','E','3'};
+
+/** @brief Rounds `n` up to a multiple of 8 */
+static std::size_t CacheAlign(std::size_t n)
+{
+	return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+/** @brief Working directory that relative include paths are resolved in */
+static std::string CurrentDirectory()
+{
+#ifdef PARSELI_HAVE_MMAP
+	std::string Dir(256,'\0');
+	while (getcwd(Dir.data(),Dir.size()) == nullptr) {
+		if (errno != ERANGE)
+			return std::string();
+		Dir.resize(Dir.size() * 2);
+	}
+	Dir.resize(std::strlen(Dir.c_str()));
+	return Dir;
+#else
+	return std::string();
+#endif
+}
+
+/**
+ * @brief Checks whether a file still matches what was recorded in a cache
+ * @param Path          Name of the file
+ * @param R             Record of the file in the cache
+ * @param S             Set to the current stamp of the file
+ * @return `True` if the file is unchanged (or still missing)
+ */
+static bool CacheRecordCurrent(std::string const &Path, CacheFileRecord const &R, FileStamp &S)
+{
+	S = StampFile(Path.c_str());
+	if (!R.Opened)
+		return !S.Exists;
+	if (!S.Exists || S.Size != R.Size)
+		return false;
+	if (S.MTime != 0 && S.MTime == R.MTime)
+		return true;
+	//Touched (or no timestamps available): compare contents
+	MappedFile f_in;
+	return f_in.Open(Path.c_str()) && HashContents(f_in.View()) == R.Hash;
+}
+
+/**
+ * @brief Checks a recorded operation of a cache image before it is used in place
+ * @param p             Start of the operation in the image
+ * @param TextLength    Length of the text of its file
+ * @return `True` if its kind, severity, value type and error are known
+ * 	values and its strings lie within the text
+ */
+static bool CachedOpValid(const char* p, std::uint64_t TextLength)
+{
+	//The flag is checked as a byte first; any other value is not a valid bool
+	unsigned char HasType;
+	std::memcpy(&HasType,p + offsetof(FragmentOp,Val) + offsetof(ParsedValue,HasType),1);
+	if (HasType > 1)
+		return false;
+	FragmentOp Op;
+	std::memcpy(static_cast<void*>(&Op),p,sizeof(Op));
+	auto Within = [TextLength](std::uint64_t Offset, std::uint64_t Length) {
+		return Offset <= TextLength && Length <= TextLength - Offset;
+	};
+	return Op.Type <= FragmentOp::Kind::Binary && Op.Level <= Severity::Error &&
+		Op.Val.Type >= ValueType::Int && Op.Val.Type <= ValueType::DoubleArray &&
+		(Op.Val.Error == std::errc() || Op.Val.Error == std::errc::invalid_argument || Op.Val.Error == std::errc::result_out_of_range) &&
+		Within(Op.NameOffset,Op.NameLength) && Within(Op.TextOffset,Op.TextLength);
+}
+
+/** @class CachedConfig
+ * @brief A cache image mapped into memory, serving its fragments in place
+ */
+class CachedConfig : public FragmentStore
+{
+	MappedFile Image;
+	std::unordered_map<std::string,FragmentView> Files;
+	public:
+	/**
+	 * @param CacheName     Name of the cache image
+	 * @param Debug         Whether debug messages are wanted
+	 * @return `True` if the image exists, is well formed, was written with
+	 * 	the same settings and every file it depends on is unchanged
+	 */
+	bool Open(std::string const &CacheName, bool Debug)
+	{
+		if (!Image.Open(CacheName.c_str()))
+			return false;
+		std::string_view Data = Image.View();
+		std::size_t pos = 0;
+		auto Take = [&](std::size_t n) -> const char* {
+			if (Data.length() - pos < n)
+				return nullptr;
+			const char* p = Data.data() + pos;
+			pos += CacheAlign(n);
+			if (pos > Data.length())
+				pos = Data.length();
+			return p;
+		};
+
+		CacheHeader H;
+		const char* p = Take(sizeof(H));
+		if (!p) return false;
+		std::memcpy(&H,p,sizeof(H));
+		if (std::memcmp(H.Magic,CacheMagic,sizeof(CacheMagic)) != 0 || H.OpSize != sizeof(FragmentOp) || H.Debug != (Debug ? 1u : 0u))
+			return false;
+		const char* Cwd = Take(H.CwdLength);
+		if (!Cwd || std::string_view(Cwd,H.CwdLength) != CurrentDirectory())
+			return false;
+
+		for (std::uint64_t i = 0; i < H.FileCount; i++) {
+			CacheFileRecord R;
+			if (!(p = Take(sizeof(R)))) return false;
+			std::memcpy(&R,p,sizeof(R));
+			const char* Path = Take(R.PathLength);
+			if (!Path || R.OpCount > Data.length() / sizeof(FragmentOp)) return false;
+			const char* Ops = Take(R.OpCount * sizeof(FragmentOp));
+			const char* Text = Take(R.TextLength);
+			if (!Ops || !Text) return false;
+
+			std::string PathName(Path,R.PathLength);
+			FragmentView F;
+			if (!CacheRecordCurrent(PathName,R,F.Stamp))
+				return false;
+			F.Opened = R.Opened != 0;
+			F.Ok = R.Ok != 0;
+			F.Ops = reinterpret_cast<const FragmentOp*>(Ops);
+			F.OpCount = R.OpCount;
+			F.Text = Text;
+			for (std::size_t j = 0; j < F.OpCount; j++)
+				if (!CachedOpValid(Ops + j * sizeof(FragmentOp),R.TextLength))
+					return false;
+			auto it = Files.emplace(std::move(PathName),F).first;
+			it->second.Filename = it->first;
+		}
+		return true;
+	}
+
+	bool Find(std::string const &Path, FragmentView &Out) const override
+	{
+		auto it = Files.find(Path);
+		if (it == Files.end())
+			return false;
+		Out = it->second;
+		return true;
+	}
+};
+
+/**
+ * @brief Writes a cache image for a file and everything it included
+ * @param CacheName     Name of the cache image
+ * @param Parsed        Every file parsed while reading the configuration
+ * @param Debug         Whether debug messages were recorded
+ * @return `True` if the image was written
+ * @note The image is written to a temporary file of its own and renamed
+ * 	into place only if it was written completely, so concurrent readers
+ * 	and writers never see a partial image.
+ */
+static bool WriteCache(std::string const &CacheName, std::unordered_map<std::string,Fragment*> const &Parsed, bool Debug)
+{
+	std::string Image;
+	auto Put = [&Image](const void* p, std::size_t n) {
+		Image.append(static_cast<const char*>(p),n);
+		Image.resize(CacheAlign(Image.length()),'\0');
+	};
+	std::string Cwd = CurrentDirectory();
+	CacheHeader H{};
+	std::memcpy(H.Magic,CacheMagic,sizeof(CacheMagic));
+	H.OpSize = sizeof(FragmentOp);
+	H.Debug = Debug ? 1 : 0;
+	H.CwdLength = Cwd.length();
+	H.FileCount = Parsed.size();
+	Put(&H,sizeof(H));
+	Put(Cwd.data(),Cwd.length());
+	for (auto const &[Path, F] : Parsed) {
+		CacheFileRecord R{};
+		R.PathLength = Path.length();
+		R.Size = F->Stamp.Size;
+		R.MTime = F->Stamp.MTime;
+		R.Hash = F->Hash;
+		R.OpCount = F->Ops.size();
+		R.TextLength = F->Text.length();
+		R.Opened = F->Opened ? 1 : 0;
+		R.Ok = F->Ok ? 1 : 0;
+		Put(&R,sizeof(R));
+		Put(Path.data(),Path.length());
+		//Copy the operations member by member into zeroed ones, so no stray padding bytes are written
+		std::vector<FragmentOp> Ops(F->Ops.size());
+		for (std::size_t i = 0; i < Ops.size(); i++) {
+			FragmentOp const &Op = F->Ops[i];
+			Ops[i].Type = Op.Type;
+			Ops[i].Level = Op.Level;
+			Ops[i].Line = Op.Line;
+			Ops[i].NameOffset = Op.NameOffset;
+			Ops[i].NameLength = Op.NameLength;
+			Ops[i].TextOffset = Op.TextOffset;
+			Ops[i].TextLength = Op.TextLength;
+			Ops[i].Val.HasType = Op.Val.HasType;
+			Ops[i].Val.Type = Op.Val.Type;
+			Ops[i].Val.Error = Op.Val.Error;
+			Ops[i].Val.Int = Op.Val.Int;
+			Ops[i].Val.Double = Op.Val.Double;
+		}
+		Put(Ops.data(),Ops.size() * sizeof(FragmentOp));
+		Put(F->Text.data(),F->Text.length());
+	}
+
+	//Every writer gets a temporary file of its own, even across processes
+#ifdef PARSELI_HAVE_MMAP
+	std::string TempName = CacheName + ".tmpXXXXXX";
+	int fd = mkstemp(TempName.data());
+	if (fd < 0)
+		return false;
+	bool Written = (fchmod(fd,0644) == 0); //mkstemp creates the file readable by its owner only
+	for (std::size_t Done = 0; Written && Done < Image.length(); ) {
+		ssize_t n = write(fd,Image.data() + Done,Image.length() - Done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		Written = (n > 0);
+		if (Written)
+			Done += static_cast<std::size_t>(n);
+	}
+	if (close(fd) != 0)
+		Written = false;
+#else
+	std::random_device Random;
+	std::string TempName = CacheName + ".tmp" + std::to_string(Random()) + std::to_string(Random());
+	bool Written;
+	{
+		std::ofstream f_out(TempName,std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+		Written = static_cast<bool>(f_out.write(Image.data(),static_cast<std::streamsize>(Image.length())));
+		f_out.close();
+		Written = Written && !f_out.fail();
+	}
+#endif
+	if (!Written || std::rename(TempName.c_str(),CacheName.c_str()) != 0) {
+		std::remove(TempName.c_str());
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Reads a configuration file into a Dict or a BindingTarget, as ReadConfig() describes
+ * @param filename      Name of the configuration file to read
+ * @param D             Receiver of the values
+ * @param Options       How to read the file
+ * @return `True` on successful read of config file
+ */
+template <class Target>
+static bool ReadInto(const char* filename, Target* D, ReadOptions const &Options)
+{
+	if (Options.Cache) {
+		std::string CacheName = std::string(filename) + ".plcache";
+		CachedConfig Cached;
+		FragmentView Top;
+		if (Cached.Open(CacheName,Options.Debug) && Cached.Find(filename,Top)) {
+			if (Options.Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Loaded " + std::string(filename) + " from cache " + CacheName;});
+			IncludeChain Chain;
+			return ApplyFragment(Top,filename,D,Cached,Chain,Options.Debug);
+		}
+	} else if (Options.ParseThreads > 0) {
+		MappedFile f_in;
+		if (!f_in.Open(filename)) return false;
+		if (Options.Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Opened " + std::string(filename) + " for input";});
+		bool ret = ParseChunked(f_in.View(),filename,f_in.GetStamp(),D,Options);
+		D->Filename = std::string(filename);
+		if (ret && Options.Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Completed parsing " + std::string(filename);});
+		return ret;
+	} else if (Options.IncludeThreads == 0) {
+		return ReadFile(filename,D,Options.Debug);
+	}
+
+	IncludePrefetcher Prefetched(Options.IncludeThreads,Options.Debug,Options.Cache,Options.IoUring);
+	Prefetched.Request(filename);
+	Prefetched.Wait();
+	FragmentView Top;
+	Prefetched.Find(filename,Top);
+	if (Options.Cache && Top.Opened && !WriteCache(std::string(filename) + ".plcache",Prefetched.Parsed(),Options.Debug) && Options.Debug)
+		Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Could not write cache for " + std::string(filename);});
+	IncludeChain Chain;
+	return ApplyFragment(Top,filename,D,Prefetched,Chain,Options.Debug);
+}
+
+/**
+ * @brief Reads a stream into a Dict or a BindingTarget, as ReadConfig() describes
+ * @param f_in          Generic stream file input
+ * @param D             Receiver of the values
+ * @param Options       How to read the stream
+ * @return `True` on successful read of config
+ */
+template <class Target>
+static bool ReadStreamInto(std::istream &f_in, Target* D, ReadOptions const &Options)
+{
+	f_in.seekg(0,f_in.beg);
+	const char* filename = "(streamed input)";
+	bool Debug = Options.Debug;
+	if (Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[&]{return "Opened " + std::string(filename) + " for input";});
+
+	bool ret;
+	IncludeChain Chain;
+	Chain.Files.push_back({FileStamp(),filename});
+	if (Options.ParseThreads > 0) {
+		std::string Buffer{std::istreambuf_iterator<char>(f_in),std::istreambuf_iterator<char>()};
+		if (f_in.bad()) {
+			Diagnose(Severity::Error,filename,0,std::string_view(),[&]{return "An error occurred while reading " + std::string(filename) + ".  Failed to load.";});
+			return false;
+		}
+		ret = ParseChunked(Buffer,filename,FileStamp(),D,Options);
+	} else if (Options.IncludeThreads == 0) {
+		IncludeLoader Includes(Debug);
+		DictSink<Target> Sink(D,filename,Includes,Chain,Debug);
+		ParseExtent Extent;
+		ret = ParseStream(filename,f_in,Sink,Debug,&Extent);
+		CountParsed(filename,Extent);
+	} else {
+		IncludePrefetcher Prefetched(Options.IncludeThreads,Debug,false,Options.IoUring);
+		Fragment F;
+		F.Filename = filename;
+		F.Opened = true;
+		RecordingSink Recorder(F,&Prefetched,Debug);
+		DictSink<Target> Sink(D,filename,Prefetched,Chain,Debug);
+		ParseExtent Extent;
+		F.Ok = ParseStream(filename,f_in,Recorder,Debug,&Extent);
+		CountParsed(filename,Extent);
+		Prefetched.Wait();
+		ret = ReplayFragment(F.View(),Sink);
+	}
+	if (ret && Debug) Diagnose(Severity::Debug,filename,0,std::string_view(),[]{return std::string("Completed parsing (streamed input)");});
+	return ret;
+}
+
+/**
+ * @param filename      Name of the configuration file to read
+ * @param D             Dictionary where information is loaded to
  * @param Debug         Whether to print debugging information
  * @return `True` on successful read of config file
  * @return `False` if an error occurs, with accompanying output to stdout
@@ -500,7 +5017,11 @@ static bool ValueHandler(const char* filename, const char* Buffer, int &ln, Dict
  *	This could be mitigated by adding a separate dictionary for all
  *	enforced values.
  * @note Enforcement only applies to 'std::string' types.
- * @warning The `include` keyword does not have recursion detection.
+ * @note Regular files are memory mapped and tokenized in place; there is no
+ * 	limit on line length.
+ * @note Each included file is parsed once per call, however many times (and
+ * 	under whichever names) it is included.  A file including one that is
+ * 	still being read is reported as an include cycle and skipped.
  * @note Example inputs:
  * @code{.unparsed}
 		#Any line starting with a '#' is considered a comment line.
@@ -521,23 +5042,94 @@ static bool ValueHandler(const char* filename, const char* Buffer, int &ln, Dict
 */
 bool ReadConfig(const char* filename, Dict* D, bool Debug /*=false*/)
 {
-	using std::cerr, std::endl;
-	//Check file exists (old C-way)
-	FILE *f{fopen(filename,"r")};
-	if (f == NULL) return false;
-	else fclose(f);
-
-	//Open file for reading
-	std::ifstream f_in(filename,std::ifstream::in);
-	if (Debug) cerr << "Opened " << filename << " for input" << endl;
-	
-	bool ret = ReadConfig(f_in,D,Debug);
-	D->Filename = std::string(filename);
-	
-	f_in.close();
-	return ret;
+	DiagnosticsScope Scope(nullptr);
+	return ReadFile(filename,D,Debug);
 };
 
+/**
+ * @param filename      Name of the configuration file to read
+ * @param D             Dictionary where information is loaded to
+ * @param Options       How to read the file
+ * @return `True` on successful read of config file
+ * @return `False` if an error occurs, with accompanying output to stdout
+ *
+ * If `Options.IncludeThreads` is non-zero, the file and every file it
+ * (recursively) includes are parsed concurrently into private fragments,
+ * which are then applied to `D` in the order the sequential reader would
+ * use; the resulting dictionary, `enforce` checks and `BREAK` handling are
+ * identical.  Unless `Options.IoUring` is cleared, those files are opened
+ * and read through io_uring where the system allows it, and on the include
+ * threads otherwise.
+ *
+ * If `Options.ParseThreads` is non-zero, a large file is split at line
+ * boundaries and its chunks are parsed concurrently, then applied in line
+ * order with the same results as a sequential read.
+ *
+ * If `Options.Cache` is set, the parsed file and its includes are saved to
+ * `<filename>.plcache`.  Later reads replay that image instead of parsing,
+ * for as long as none of the files it was built from has changed.
+ * `ParseThreads` does not apply when caching.
+*/
+bool ReadConfig(const char* filename, Dict* D, ReadOptions const &Options)
+{
+	DiagnosticsScope Scope(Options.Diagnostics);
+	return ReadInto(filename,D,Options);
+}
+
+/** @brief Options for a background read, which reads includes concurrently unless told how to read */
+static ReadOptions AsyncOptions(ReadOptions Options)
+{
+	if (Options.IncludeThreads == 0 && Options.ParseThreads == 0)
+		Options.IncludeThreads = 1;
+	return Options;
+}
+
+/**
+ * @param filename      Name of the configuration file to read
+ * @param D             Dictionary where information is loaded to (must not be
+ * 	used until the read completes)
+ * @param Options       How to read the file (see ReadConfig(const char*, Dict*, ReadOptions const&))
+ * @return Future holding what ReadConfig() returns, or the exception it threw
+ *
+ * The read runs on a thread of its own, so the caller can do other work
+ * (e.g. load a mesh) while files are opened and read.  If neither
+ * `IncludeThreads` nor `ParseThreads` is set, one include thread is used,
+ * so the included files are opened and read (through io_uring, where
+ * available) while the file including them is still being parsed.
+ * @note As for std::async, destroying the future waits for the read.
+*/
+std::future<bool> ReadConfigAsync(std::string filename, Dict* D, ReadOptions const &Options)
+{
+	return std::async(std::launch::async,[filename = std::move(filename),D,Options = AsyncOptions(Options)]{
+		return ReadConfig(filename.c_str(),D,Options);
+	});
+}
+
+/**
+ * @param filename      Name of the configuration file to read
+ * @param D             Dictionary where information is loaded to (must not be
+ * 	used until `Done` is called)
+ * @param Done          Called on the reading thread with what ReadConfig()
+ * 	returns (`false` if it threw)
+ * @param Options       How to read the file (see ReadConfigAsync(std::string, Dict*, ReadOptions const&))
+ *
+ * The read runs on a detached thread; `D`, and anything `Done` uses, must
+ * outlive it.
+*/
+void ReadConfigAsync(std::string filename, Dict* D, std::function<void(bool)> Done, ReadOptions const &Options)
+{
+	std::thread([filename = std::move(filename),D,Done = std::move(Done),Options = AsyncOptions(Options)]{
+		bool ret;
+		try {
+			ret = ReadConfig(filename.c_str(),D,Options);
+		} catch (...) {
+			ret = false;
+		}
+		if (Done)
+			Done(ret);
+	}).detach();
+}
+
 /**
  * @param f_in          Generic stream file input
  * @param D             Dictionary where information is loaded to
@@ -547,60 +5139,396 @@ bool ReadConfig(const char* filename, Dict* D, bool Debug /*=false*/)
 */
 bool ReadConfig(std::istream &f_in, Dict* D, bool Debug /*=false*/)
 {
-	using std::cerr, std::endl;
-	f_in.seekg(0,f_in.beg);
-	const char* filename = "(streamed input)";
-	char Buffer[512];
+	ReadOptions Options;
+	Options.Debug = Debug;
+	return ReadConfig(f_in,D,Options);
+};
 
-	int ln{0};
-	if (Debug) cerr << "Opened " << filename << " for input" << endl;
+/**
+ * @param f_in          Generic stream file input
+ * @param D             Dictionary where information is loaded to
+ * @param Options       How to read the stream (see ReadConfig(const char*, Dict*, ReadOptions const&);
+ * 	`Cache` does not apply to streams)
+ * @return `True` on successful read of config
+ * @return `False` if an error occurs, with accompanying output to stdout
+*/
+bool ReadConfig(std::istream &f_in, Dict* D, ReadOptions const &Options)
+{
+	DiagnosticsScope Scope(Options.Diagnostics);
+	return ReadStreamInto(f_in,D,Options);
+};
 
-	while (f_in) {
-		std::string VarName;
-		std::string VarVal;
-		int siter {0}; //string iter
-		ln += 1;
-		//Read line from buffer;
-		f_in.getline(Buffer,512);
+/**
+ * @param filename      Name of the configuration file to read
+ * @param B             Receiver of the values (see Schema)
+ * @param Options       How to read the file (see ReadConfig(const char*, Dict*, ReadOptions const&))
+ * @return `True` on successful read of config file
+ * @return `False` if an error occurs or a value does not match the type of
+ * 	its field; every such value is reported first
+ *
+ * Values are offered to `B` in the order a Dict would receive them, so
+ * the first definition of a key wins and `include`, `enforce` and `BREAK`
+ * behave as they do for a Dict.  Keys `B` does not know are reported as
+ * warnings and otherwise ignored.
+ */
+bool ReadConfig(const char* filename, SchemaBinding &B, ReadOptions const &Options)
+{
+	DiagnosticsScope Scope(Options.Diagnostics);
+	BindingTarget T(B);
+	bool ret = ReadInto(filename,&T,Options);
+	return ret && !T.Mismatched;
+}
+
+/**
+ * @param f_in          Generic stream file input
+ * @param B             Receiver of the values (see Schema)
+ * @param Options       How to read the stream (`Cache` does not apply to streams)
+ * @return `True` on successful read of config
+ * @return `False` if an error occurs or a value does not match the type of
+ * 	its field
+ */
+bool ReadConfig(std::istream &f_in, SchemaBinding &B, ReadOptions const &Options)
+{
+	DiagnosticsScope Scope(Options.Diagnostics);
+	BindingTarget T(B);
+	bool ret = ReadStreamInto(f_in,&T,Options);
+	return ret && !T.Mismatched;
+}
+
+/*
+	Configuration watcher
+*/
+
+/** @brief Whether a file differs from when it was stamped */
+static bool StampChanged(FileStamp const &A, FileStamp const &B)
+{
+	return A.Exists != B.Exists || A.Size != B.Size || A.MTime != B.MTime || A.Device != B.Device || A.Inode != B.Inode;
+}
 
-		//Return if file failed to read;
-		if (f_in.fail() && !f_in.eof()) {
-			cerr << "An error occurred while reading " << filename << ".  Failed to load." << endl;
-			cerr << "Characters in buffer: " << endl << Buffer << endl;
+/** @class WatchedFiles
+ * @brief Fragments of a watched configuration, kept between reloads
+ *
+ * Files are parsed when first included and kept until they change, so a
+ * reload only parses the files that were invalidated.
+ */
+class WatchedFiles : public FragmentStore
+{
+	mutable std::unordered_map<std::string,std::unique_ptr<Fragment>> Files;
+	mutable std::unordered_set<std::string> Used; ///<Files found since the last ClearUsed()
+	bool Debug;
+	public:
+	explicit WatchedFiles(bool Debug_) : Debug(Debug_) {}
+
+	bool Find(std::string const &Path, FragmentView &Out) const override
+	{
+		std::unique_ptr<Fragment> &Slot = Files[Path];
+		if (!Slot)
+			Slot = std::make_unique<Fragment>(LoadFragment(Path,nullptr,Debug,false));
+		Used.insert(Path);
+		Out = Slot->View();
+		return true;
+	}
+
+	/** @brief Forgets `Path` if it changed since it was parsed
+	 * @return `True` if it changed */
+	bool Invalidate(std::string const &Path)
+	{
+		auto it = Files.find(Path);
+		if (it == Files.end() || !StampChanged(it->second->Stamp,StampFile(Path.c_str())))
 			return false;
+		Files.erase(it);
+		return true;
+	}
+
+	/** @brief Starts tracking which files a replay uses */
+	void ClearUsed() {Used.clear();}
+	/** @brief Forgets files that the last replay did not use */
+	void DropUnused()
+	{
+		for (auto it = Files.begin(); it != Files.end(); )
+			it = Used.count(it->first) ? std::next(it) : Files.erase(it);
+	}
+
+	/** @brief Names of every file kept */
+	std::vector<std::string> Names() const
+	{
+		std::vector<std::string> Out;
+		for (auto const &F : Files)
+			Out.push_back(F.first);
+		return Out;
+	}
+};
+
+/** @brief Whether two slots (of the same type, possibly in different tables) hold the same value */
+static bool SameValue(ValueTable const &TA, ValueTable::Slot const &A, ValueTable const &TB, ValueTable::Slot const &B)
+{
+	//A mapped file that did not change need not be read to compare it
+	MappedArray const* MA = TA.MappingOf(A);
+	MappedArray const* MB = TB.MappingOf(B);
+	if (MA && MB && MA->SameFile(*MB))
+		return true;
+	switch (A.Type()) {
+		case ValueType::Int: return A.Int == B.Int;
+		case ValueType::Double: return A.Double == B.Double;
+		case ValueType::String: return TA.StringOf(A) == TB.StringOf(B);
+		case ValueType::IntArray: {
+			Span<const int> a = TA.IntsOf(A), b = TB.IntsOf(B);
+			return std::equal(a.begin(),a.end(),b.begin(),b.end());
 		}
-		if (f_in.eof())
-			break;
+		case ValueType::DoubleArray: {
+			Span<const double> a = TA.DoublesOf(A), b = TB.DoublesOf(B);
+			return std::equal(a.begin(),a.end(),b.begin(),b.end());
+		}
+	}
+	return false;
+}
 
-		if (Debug) cerr << "(" << ln << "): " << Buffer << endl;
+/** @brief Splits a path into its directory ("." if none) and file name */
+static std::pair<std::string,std::string> SplitPath(std::string const &Path)
+{
+	std::size_t slash = Path.rfind('/');
+	if (slash == std::string::npos)
+		return {".",Path};
+	return {slash == 0 ? "/" : Path.substr(0,slash),Path.substr(slash + 1)};
+}
 
-		std::string LineData = std::string(Buffer);
-		if (!SkipStringWhitespace(LineData,siter))
-			continue;
+struct ConfigWatcher::State
+{
+	std::string Filename;
+	Dict* D;
+	bool Debug;
+	DiagnosticSink* Diagnostics;
+	bool Ok = false;
+	WatchedFiles Files;
+	ValueTable Applied; ///<Configuration as of the last successful load
+	std::unordered_map<std::string,std::vector<Callback>> KeyCallbacks;
+	std::vector<Callback> AnyCallbacks;
+	SnapshotPublisher* Publisher = nullptr;
+	int Fd = -1;
+	std::unordered_map<std::string,int> DirWatches; ///<Watched directory to watch descriptor
+	std::unordered_map<int,std::string> WatchDirs;  ///<Watch descriptor to directory
 
-		//Read variable name
-		VarName = ReadValue(LineData,siter);
-		if (VarName.compare("BREAK") == 0) { //Stop reading on break signal
-			if (Debug) cerr << "Encountered \"BREAK\" signal.  Terminating input." << endl;
-			break;
+	State(std::string const &filename, Dict* D_, bool Debug_, DiagnosticSink* Diagnostics_) :
+		Filename(filename), D(D_), Debug(Debug_), Diagnostics(Diagnostics_), Files(Debug_) {}
+
+	/** @brief Watches the directory of every file in use
+	 * @note Directories are watched rather than files, so that files
+	 * 	replaced by a rename, or created later, are noticed too. */
+	void UpdateWatches()
+	{
+#ifdef PARSELI_HAVE_INOTIFY
+		if (Fd < 0)
+			return;
+		for (std::string const &Path : Files.Names()) {
+			std::string Dir = SplitPath(Path).first;
+			if (DirWatches.count(Dir))
+				continue;
+			int wd = inotify_add_watch(Fd,Dir.c_str(),IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+			if (wd < 0) {
+				if (Debug) Diagnose(Severity::Debug,Path,0,std::string_view(),[&]{return "Could not watch " + Dir;});
+				continue;
+			}
+			DirWatches[Dir] = wd;
+			WatchDirs[wd] = Dir;
 		}
-		if (VarName.length() < 1)
-			continue;
-		
-		//Read variable value
-		if (!SkipStringWhitespace(LineData,siter)) {
-			cerr << "Reached end of line " << ln << "while parsing variable: " << LineData << endl;
-			return false;
+#endif
+	}
+
+	/**
+	 * @brief Reparses the files in `Changed` that were modified and applies the differences
+	 * @param Changed       Files that may have changed
+	 * @return Number of values that changed
+	 */
+	std::size_t Refresh(std::vector<std::string> const &Changed)
+	{
+		bool Dirty = false;
+		for (std::string const &Path : Changed)
+			Dirty = Files.Invalidate(Path) || Dirty;
+		return Dirty ? Apply() : 0;
+	}
+
+	/**
+	 * @brief Replays the configuration and applies what changed to the Dict
+	 * @return Number of values that changed
+	 */
+	std::size_t Apply()
+	{
+		DiagnosticsScope Scope(Diagnostics);
+		Dict Next;
+		IncludeChain Chain;
+		FragmentView Top;
+		Files.ClearUsed();
+		Files.Find(Filename,Top);
+		Ok = ApplyFragment(Top,Filename,&Next,Files,Chain,Debug);
+		Files.DropUnused();
+		UpdateWatches();
+		if (!Ok) {
+			if (Debug) Diagnose(Severity::Debug,Filename,0,std::string_view(),[&]{return "Reload of " + Filename + " failed; keeping the previous configuration";});
+			return 0;
 		}
-		VarVal = ReadValue(LineData,siter);
-		
-		if (!ValueHandler(filename, Buffer, ln, D, siter, VarName, VarVal, LineData, Debug))
-			return false;
+
+		//Key-level difference against the previous configuration
+		std::vector<ConfigChange> Changes;
+		ValueTable const &New = Next.Table;
+		for (std::size_t i = 0; i < New.Capacity(); i++) {
+			ValueTable::Slot const &N = New[i];
+			if (N.Empty())
+				continue;
+			std::string_view Key = New.KeyOf(N);
+			std::size_t j = Applied.Find(Key,N.Hash,N.Type());
+			if (j == ValueTable::npos)
+				Changes.push_back({ConfigChange::Kind::Added,std::string(Key),N.Type(),ValueTable::Value(),New.Get(N),std::nullopt});
+			else if (!SameValue(Applied,Applied[j],New,N))
+				Changes.push_back({ConfigChange::Kind::Modified,std::string(Key),N.Type(),Applied.Get(Applied[j]),New.Get(N),std::nullopt});
+			else
+				continue;
+			if (MappedArray const* M = New.MappingOf(N))
+				Changes.back().Mapped = *M;
+		}
+		for (std::size_t i = 0; i < Applied.Capacity(); i++) {
+			ValueTable::Slot const &O = Applied[i];
+			if (!O.Empty() && New.Find(Applied.KeyOf(O),O.Hash,O.Type()) == ValueTable::npos)
+				Changes.push_back({ConfigChange::Kind::Removed,std::string(Applied.KeyOf(O)),O.Type(),Applied.Get(O),ValueTable::Value(),std::nullopt});
+		}
+		Applied = std::move(Next.Table);
+		if (Changes.empty())
+			return 0;
+
+		D->ApplyChanges(Changes);
+		D->Filename = Filename;
+		if (Publisher)
+			Publisher->Publish(*D);
+		for (ConfigChange const &C : Changes) {
+			auto it = KeyCallbacks.find(C.Key);
+			if (it != KeyCallbacks.end())
+				for (Callback const &f : it->second)
+					f(C);
+			for (Callback const &f : AnyCallbacks)
+				f(C);
+		}
+		return Changes.size();
 	}
-	if (Debug) cerr << "Completed parsing (streamed input)" << endl;
-	return true;
 };
 
+/**
+ * @param filename      Name of the configuration file to watch
+ * @param D             Dictionary kept up to date
+ * @param Options       How to read the file
+ */
+ConfigWatcher::ConfigWatcher(std::string const &filename, Dict* D, ReadOptions const &Options) :
+	S(std::make_unique<State>(filename,D,Options.Debug,Options.Diagnostics))
+{
+#ifdef PARSELI_HAVE_INOTIFY
+	S->Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (S->Fd < 0 && Options.Debug) {
+		DiagnosticsScope Scope(Options.Diagnostics);
+		Diagnose(Severity::Info,filename,0,std::string_view(),[&]{return "inotify unavailable; " + filename + " will be polled";});
+	}
+#endif
+	S->Apply();
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+#ifdef PARSELI_HAVE_INOTIFY
+	if (S->Fd >= 0)
+		close(S->Fd);
+#endif
+}
+
+/**
+ * @return `True` if the file was read, and applied, without errors
+ */
+bool ConfigWatcher::Loaded() const
+{
+	return S->Ok;
+}
+
+/**
+ * @param key Key to follow
+ * @param f Called with each change to `key`
+ */
+void ConfigWatcher::OnChange(std::string_view key, Callback f)
+{
+	S->KeyCallbacks[std::string(key)].push_back(std::move(f));
+}
+
+/**
+ * @param f Called with each change
+ */
+void ConfigWatcher::OnAnyChange(Callback f)
+{
+	S->AnyCallbacks.push_back(std::move(f));
+}
+
+/**
+ * @param P Publisher receiving a snapshot after every change (or null)
+ */
+void ConfigWatcher::PublishTo(SnapshotPublisher* P)
+{
+	S->Publisher = P;
+	if (P)
+		P->Publish(*S->D);
+}
+
+/**
+ * @return Descriptor to wait on (e.g. with `poll` or `epoll`) before calling
+ * 	Poll(0), or -1 if changes can only be found by Reload()
+ */
+int ConfigWatcher::Fd() const
+{
+	return S->Fd;
+}
+
+/**
+ * @param TimeoutMs Longest time to wait for a change, in milliseconds (-1: no limit)
+ * @return Number of values that changed
+ * @note Callbacks run on the calling thread, after the Dict has been updated.
+ */
+std::size_t ConfigWatcher::Poll(int TimeoutMs /*=-1*/)
+{
+#ifdef PARSELI_HAVE_INOTIFY
+	if (S->Fd >= 0) {
+		pollfd P{S->Fd,POLLIN,0};
+		if (poll(&P,1,TimeoutMs) <= 0)
+			return 0;
+
+		//Drain every pending event, so one save causes a single reload
+		std::vector<std::string> Changed;
+		bool Overflow = false;
+		alignas(inotify_event) char Buffer[4096];
+		ssize_t n;
+		while ((n = read(S->Fd,Buffer,sizeof(Buffer))) > 0) {
+			for (char* p = Buffer; p < Buffer + n; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+				inotify_event const* E = reinterpret_cast<inotify_event*>(p);
+				if (E->mask & IN_Q_OVERFLOW)
+					Overflow = true;
+				auto Dir = S->WatchDirs.find(E->wd);
+				if (Dir == S->WatchDirs.end() || E->len == 0)
+					continue;
+				for (std::string const &Path : S->Files.Names()) {
+					auto [PathDir, PathName] = SplitPath(Path);
+					if (PathDir == Dir->second && PathName == E->name)
+						Changed.push_back(Path);
+				}
+			}
+		}
+		return Overflow ? Reload() : S->Refresh(Changed);
+	}
+#endif
+	if (TimeoutMs > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(TimeoutMs));
+	return Reload();
+}
+
+/**
+ * @return Number of values that changed
+ */
+std::size_t ConfigWatcher::Reload()
+{
+	return S->Refresh(S->Files.Names());
+}
+
 } //Version
 } //namespace ParseLi
 
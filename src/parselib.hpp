@@ -27,13 +27,32 @@
 #ifndef PARSELIB_HPP_
 #define PARSELIB_HPP_ 1
 
+#include <algorithm> //std::copy_n, std::lower_bound
+#include <array>
+#include <atomic>
+#include <cstdint> //std::uint64_t
 #include <iostream> //std::cout, std::cerr
 #include <iomanip> //std::setw, std::left
 #include <fstream> //std::ifstream
+#include <functional> //std::function
+#include <future> //std::future
+#include <memory> //std::shared_ptr, std::atomic_load
 #include <mutex>
+#include <optional>
+#include <shared_mutex> //std::shared_mutex, std::shared_lock
 #include <stdexcept>
 #include <string>
-#include <unordered_map> //std::unordered_map
+#include <string_view>
+#include <tuple> //std::tuple, std::get
+#include <type_traits> //std::is_same_v
+#include <utility> //std::pair
+#include <variant> //std::variant, std::monostate
+#include <vector>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#endif
 
 /** @namespace ParseLi 
  * @brief The namespace encompassing the ParseLi functions
@@ -45,22 +64,795 @@ namespace ParseLi {
  */
 bool StringsEqualIgnoreCase(std::string const &S1, std::string const &S2);
 
-inline namespace V_0_0_4 {
+inline namespace V_0_0_5 {
+#if defined(__cpp_lib_span)
+/** @brief Non-owning view of contiguous values */
+template <class T>
+using Span = std::span<T>;
+#else
+/** @class Span
+ * @brief Non-owning view of contiguous values
+ *
+ * The subset of C++20's `std::span` used by ParseLi (which is an alias of
+ * `std::span` when compiled as C++20).
+*/
+template <class T>
+class Span
+{
+	T* Ptr = nullptr;
+	std::size_t Count = 0;
+	public:
+	using element_type = T;
+	using value_type = std::remove_cv_t<T>;
+	using size_type = std::size_t;
+	using iterator = T*;
+
+	constexpr Span() noexcept = default;
+	constexpr Span(T* data_, std::size_t size_) noexcept : Ptr(data_), Count(size_) {}
+	template <std::size_t N>
+	constexpr Span(T (&a)[N]) noexcept : Ptr(a), Count(N) {}
+	/** @brief Views a container with contiguous storage (`std::vector`, `std::array`, Span) */
+	template <class C, class = std::enable_if_t<std::is_convertible_v<decltype(std::declval<C&>().data()),T*>>>
+	constexpr Span(C &&c) : Ptr(c.data()), Count(c.size()) {}
+
+	constexpr T* data() const noexcept {return Ptr;}
+	constexpr std::size_t size() const noexcept {return Count;}
+	constexpr std::size_t size_bytes() const noexcept {return Count * sizeof(T);}
+	constexpr bool empty() const noexcept {return Count == 0;}
+	constexpr T& operator[](std::size_t i) const {return Ptr[i];}
+	constexpr T& front() const {return Ptr[0];}
+	constexpr T& back() const {return Ptr[Count - 1];}
+	constexpr T* begin() const noexcept {return Ptr;}
+	constexpr T* end() const noexcept {return Ptr + Count;}
+};
+#endif
+
 class Dict;
+class FrozenDict;
+class ConcurrentDict;
+class ConfigWatcher;
+class DiagnosticSink;
+
+/** @brief Options controlling how ReadConfig() loads a configuration */
+struct ReadOptions
+{
+	bool Debug = false;          ///<Whether to print debugging information
+	unsigned IncludeThreads = 0; ///<Threads used to parse `include`d files concurrently (0: read sequentially)
+	unsigned ParseThreads = 0;   ///<Threads used to parse chunks of a large input concurrently (0: read sequentially)
+	bool Cache = false;          ///<Load from, or save to, a binary cache image next to the file
+	bool IoUring = true;         ///<With IncludeThreads, open and read files through io_uring where the system allows it
+	DiagnosticSink* Diagnostics = nullptr; ///<Receiver of the messages of this read (null: the one set by SetDiagnostics())
+};
+
 /**
  * @brief Reads a configuration file into a Dict pointer
 */
 bool ReadConfig(const char* filename, Dict* D, bool Debug = false);
+/** @overload */
+bool ReadConfig(const char* filename, Dict* D, ReadOptions const &Options);
 
 /**
  * @brief Reads from any input stream (istream) into a Dict pointer
 */
 bool ReadConfig(std::istream &f_in, Dict* D, bool Debug =false);
+/** @overload */
+bool ReadConfig(std::istream &f_in, Dict* D, ReadOptions const &Options);
+
+/**
+ * @brief Reads a configuration file into a Dict pointer on a background thread
+*/
+std::future<bool> ReadConfigAsync(std::string filename, Dict* D, ReadOptions const &Options = ReadOptions());
+/** @overload */
+void ReadConfigAsync(std::string filename, Dict* D, std::function<void(bool)> Done, ReadOptions const &Options = ReadOptions());
+
+/** @brief Type of a value held in a Dict
+ *
+ * The enumerator values match the alternatives of ValueTable::Value so that
+ * a slot's type is simply the index of its variant.
+ */
+enum class ValueType : unsigned char {
+	Int = 1,    ///<`int` value
+	Double = 2, ///<`double` value
+	String = 3, ///<`std::string` value
+	IntArray = 4,   ///<Array of `int` values
+	DoubleArray = 5 ///<Array of `double` values
+};
+
+/** @brief Memory held by a dictionary, for measuring per-entry overhead */
+struct MemoryStats
+{
+	std::size_t Entries = 0;       ///<Number of stored values
+	std::size_t SlotBytes = 0;     ///<Slot array (including retained chunks)
+	std::size_t ArenaBytes = 0;    ///<Arena pages holding keys and strings
+	std::size_t ArenaUsed = 0;     ///<Bytes of the arena in use
+	std::size_t InternBytes = 0;   ///<String interning index
+	std::size_t Strings = 0;       ///<Distinct strings stored in the arena
+	std::size_t SharedBytes = 0;   ///<Part of the above shared with copies of the dictionary
+	std::size_t MappedBytes = 0;   ///<Files mapped by MappedArray values (not included in Total())
+
+	/** @brief Total bytes held */
+	std::size_t Total() const {return SlotBytes + ArenaBytes + InternBytes;}
+	/** @brief Adds the figures of `M` (e.g. of another table) */
+	MemoryStats& operator+=(MemoryStats const &M)
+	{
+		Entries += M.Entries;
+		SlotBytes += M.SlotBytes;
+		ArenaBytes += M.ArenaBytes;
+		ArenaUsed += M.ArenaUsed;
+		InternBytes += M.InternBytes;
+		Strings += M.Strings;
+		SharedBytes += M.SharedBytes;
+		MappedBytes += M.MappedBytes;
+		return *this;
+	}
+	/** @brief Bytes held per stored value */
+	double PerEntry() const {return Entries ? static_cast<double>(Total()) / Entries : 0.0;}
+};
+
+/** @brief Accessor family of a lookup, for Stats */
+enum class LookupKind : unsigned char {
+	Get = 0,    ///<`Get...` (throws if the key is missing)
+	TryGet = 1, ///<`TryGet...` and `GetOr`
+	Check = 2,  ///<`Check...`
+	Handle = 3  ///<Resolving a Dict::Handle (reads through a resolved handle are not counted)
+};
+
+/** @brief Parsing of one input file, summed over every time it was read */
+struct FileStats
+{
+	std::string Filename;
+	std::uint64_t Reads = 0;  ///<Times the file was read or included
+	std::uint64_t Bytes = 0;  ///<Bytes parsed (a read replayed from a cache parses nothing)
+	std::uint64_t Lines = 0;  ///<Lines parsed
+	double Seconds = 0.0;     ///<Time spent on the file, including the files it includes
+	std::uint64_t Entries[6] = {0,0,0,0,0,0}; ///<Values stored from the file's own lines, by ValueType
+};
+
+/** @brief Hits and misses of one kind of lookup */
+struct LookupCounts
+{
+	std::uint64_t Hits = 0;
+	std::uint64_t Misses = 0;
+};
+
+/** @brief A frequently looked-up key */
+struct HotKey
+{
+	std::string Key;
+	std::uint64_t Count = 0; ///<Estimated lookups (about one lookup in 16 is sampled)
+};
+
+/** @brief Counters of parsing and lookups, returned by GetStats()
+ *
+ * Nothing is counted until EnableStats() is called, and counting costs
+ * a few relaxed increments per lookup: every thread counts into its own
+ * block, which GetStats() adds up.  Building with `PARSELI_NO_STATS`
+ * defined removes the counting altogether.
+ *
+ * The time of a file runs from reading it to applying its last line, so it
+ * includes the files it includes.  Files parsed ahead of time on other
+ * threads (ReadOptions::IncludeThreads) only count the time to apply them.
+ * Lookups are counted for Dict, FrozenDict and ConcurrentDict alike; lock
+ * waits only for Dict.
+ */
+struct Stats
+{
+	std::vector<FileStats> Files;  ///<Files read, by name
+	LookupCounts Lookups[4][6];    ///<Lookups by LookupKind and ValueType
+	std::uint64_t LockWaits = 0;   ///<Times the lock of a Dict was already held
+	double LockWaitSeconds = 0.0;  ///<Time spent waiting for those locks
+	std::vector<HotKey> HotKeys;   ///<Most looked-up keys, most frequent first
+
+	/** @brief Lookups of kind `kind` over all types */
+	LookupCounts Total(LookupKind kind) const;
+	/** @brief The counters as readable text */
+	std::string ToString() const;
+};
+
+/** @brief Starts (or with `false`, stops) gathering Stats; off by default */
+void EnableStats(bool on = true);
+/** @brief Whether Stats are being gathered */
+bool StatsEnabled();
+/** @brief Counters gathered since the last ResetStats(), with the `TopKeys` hottest keys */
+Stats GetStats(std::size_t TopKeys = 10);
+/** @brief Sets every counter back to zero */
+void ResetStats();
+
+/** @brief Importance of a Diagnostic */
+enum class Severity : unsigned char {
+	Debug = 0,   ///<Progress of a read with `Debug` set
+	Info = 1,    ///<Something worth knowing that needs no action (also only reported with `Debug` set)
+	Warning = 2, ///<A `WARNING` directive
+	Error = 3    ///<A failed read, enforcement or lookup
+};
+
+/** @brief A message from the parser or a dictionary */
+struct Diagnostic
+{
+	Severity Level = Severity::Error;
+	std::string File;    ///<Input file concerned (empty if none)
+	int Line = 0;        ///<Line of `File` (0 if unknown)
+	std::string Key;     ///<Key concerned (empty if none)
+	std::string Message; ///<The message, as printed by StreamDiagnostics
+};
+
+/** @brief `D` as StreamDiagnostics prints it (without a newline) */
+std::string FormatDiagnostic(Diagnostic const &D);
+
+/** @class DiagnosticSink
+ * @brief Receiver of the messages of the parser and the dictionaries
+ *
+ * Records are only built for the levels a sink Wants(), so a sink that
+ * ignores Debug records costs nothing while reading with `Debug` set.
+ * Report() may be called from several threads at once; Flush() is called
+ * at the end of each read and each watcher poll.
+ */
+class DiagnosticSink
+{
+	public:
+	virtual ~DiagnosticSink() = default;
+	/** @brief Whether records of `Level` should be reported */
+	virtual bool Wants(Severity) const {return true;}
+	/** @brief Receives one record */
+	virtual void Report(Diagnostic const &D) = 0;
+	/** @brief Ends a batch of records */
+	virtual void Flush() {}
+};
+
+/** @class StreamDiagnostics
+ * @brief Prints records to a stream (by default std::cerr, as ParseLi used to)
+ *
+ * Records are collected in a buffer and written in one go when a batch
+ * ends (or the buffer fills up) rather than flushing the stream after
+ * every line.  Errors are written at once, since a failed lookup is
+ * reported outside any batch just before it throws.
+ */
+class StreamDiagnostics : public DiagnosticSink
+{
+	std::ostream &Out;
+	Severity Min;
+	std::mutex Mutex;
+	std::string Pending; ///<Text not yet written to `Out`
+	public:
+	/** @brief Prints records of level `Min_` and above to `Out_` */
+	explicit StreamDiagnostics(std::ostream &Out_ = std::cerr, Severity Min_ = Severity::Debug) : Out(Out_), Min(Min_) {}
+	~StreamDiagnostics() override {Flush();}
+	bool Wants(Severity Level) const override {return Level >= Min;}
+	void Report(Diagnostic const &D) override;
+	void Flush() override;
+};
+
+/** @class BufferedDiagnostics
+ * @brief Keeps records in memory until they are asked for
+ */
+class BufferedDiagnostics : public DiagnosticSink
+{
+	Severity Min;
+	std::size_t Capacity;
+	mutable std::mutex Mutex;
+	std::vector<Diagnostic> Records;
+	mutable std::size_t Dropped = 0;
+	public:
+	/** @brief Keeps up to `Capacity_` records of level `Min_` and above (later ones are counted but dropped) */
+	explicit BufferedDiagnostics(Severity Min_ = Severity::Debug, std::size_t Capacity_ = 100000) : Min(Min_), Capacity(Capacity_) {}
+	/** @brief Whether a record of `Level` is wanted and fits (a record that does not fit is counted as dropped) */
+	bool Wants(Severity Level) const override;
+	void Report(Diagnostic const &D) override;
+	/** @brief Returns the records kept so far and empties the buffer */
+	std::vector<Diagnostic> Take();
+	/** @brief Number of records dropped because the buffer was full */
+	std::size_t DroppedCount() const;
+	/** @brief Prints the records kept so far as StreamDiagnostics would */
+	void Print(std::ostream &Out = std::cerr) const;
+};
+
+/** @class CallbackDiagnostics
+ * @brief Passes each record to a function (one record at a time)
+ */
+class CallbackDiagnostics : public DiagnosticSink
+{
+	std::function<void(Diagnostic const&)> Callback;
+	Severity Min;
+	std::mutex Mutex;
+	public:
+	/** @brief Calls `Callback_` with each record of level `Min_` and above */
+	explicit CallbackDiagnostics(std::function<void(Diagnostic const&)> Callback_, Severity Min_ = Severity::Debug) :
+		Callback(std::move(Callback_)), Min(Min_) {}
+	bool Wants(Severity Level) const override {return Level >= Min;}
+	void Report(Diagnostic const &D) override;
+};
+
+/** @brief Sends all messages to `Sink` (null: discards them); returns the previous sink */
+std::shared_ptr<DiagnosticSink> SetDiagnostics(std::shared_ptr<DiagnosticSink> Sink);
+/** @brief The sink set by SetDiagnostics() (initially a StreamDiagnostics on std::cerr) */
+std::shared_ptr<DiagnosticSink> GetDiagnostics();
+
+/** @class MappedArray
+ * @brief A raw binary file of `int` or `double` values, mapped read-only
+ *
+ * The file holds nothing but the values, in native byte order.  It is
+ * mapped shared and read-only, so opening it takes the same time whatever
+ * its size, nothing is parsed or copied, and its pages come from the page
+ * cache: every process on the node mapping the file shares one copy.
+ * Copies of a MappedArray (and the dictionaries holding it) share the
+ * mapping, which is released along with the last of them.
+ * @note Replace a mapped file (write a new file and rename it over the old
+ * 	one) rather than modifying it in place, since changes to the file show
+ * 	through every mapping of it.
+ * @note Where `mmap` is unavailable the file is read into memory instead.
+*/
+class MappedArray
+{
+	std::shared_ptr<const char> Data;
+	std::size_t Bytes = 0;
+	ValueType Type = ValueType::DoubleArray;
+	std::uint64_t Device = 0; ///<Device holding the file (0 if unknown)
+	std::uint64_t Inode = 0;  ///<Inode of the file (0 if unknown)
+	std::int64_t MTime = 0;   ///<Modification time of the file in nanoseconds
+	public:
+	MappedArray() = default;
+
+	/** @brief Maps `filename` as an array of type `type` (ValueType::IntArray or ValueType::DoubleArray) */
+	bool Open(const char* filename, ValueType type);
+
+	/** @brief Type of the values (ValueType::IntArray or ValueType::DoubleArray) */
+	ValueType GetType() const {return Type;}
+	/** @brief Number of values */
+	std::size_t size() const {return Bytes / (Type == ValueType::IntArray ? sizeof(int) : sizeof(double));}
+	/** @brief Bytes of the file */
+	std::size_t MappedBytes() const {return Bytes;}
+	/** @brief Values of an array of type ValueType::IntArray */
+	Span<const int> Ints() const {return Span<const int>(reinterpret_cast<const int*>(Data.get()),Bytes / sizeof(int));}
+	/** @brief Values of an array of type ValueType::DoubleArray */
+	Span<const double> Doubles() const {return Span<const double>(reinterpret_cast<const double*>(Data.get()),Bytes / sizeof(double));}
+	/** @brief Whether both arrays map the same file, unmodified, with the same type (false if unknown) */
+	bool SameFile(MappedArray const &M) const
+	{
+		return Inode != 0 && Device == M.Device && Inode == M.Inode && MTime == M.MTime && Bytes == M.Bytes && Type == M.Type;
+	}
+};
+
+/** @class ValueTable
+ * @brief Flat open-addressing hash table of tagged values
+ *
+ * All keys and values live in one array of slots which is searched by
+ * linear probing, so a lookup costs one hash and one probe sequence
+ * regardless of the type requested.  The same key may be stored once per
+ * ValueType; these entries share a probe sequence since only the key is
+ * hashed.
+ *
+ * Keys and string values are not allocated individually: they are
+ * appended to an arena owned by the table, and identical strings (a key
+ * used with several types, repeated `TRUE`/`FALSE` switches) are interned
+ * so they are stored once.  Slots refer to them by offset, which keeps a
+ * slot small and trivially copyable.
+ *
+ * The slot array, the interning index and the arena are split into
+ * reference-counted chunks and pages.  Copying a table shares all of them,
+ * and a write copies only the chunk or page it touches if it is still
+ * shared, so many variants of one configuration cost the memory of their
+ * differences.
+ *
+ * An array may instead refer to a MappedArray, which the table keeps alive
+ * (shared between copies like the arena) rather than copying its values.
+ * @note This class performs no locking; Dict guards it with its mutex.
+ * 	Tables sharing chunks may be used from different threads.
+ * @note Arena space is not reclaimed when values are replaced or erased,
+ * 	only when the table is destroyed or replaced by Compacted() (nor are
+ * 	the files they mapped unmapped).  The arena is limited to 4 GiB.
+ * @note Once RetainSlots() has been called, slot chunks replaced by growth,
+ * 	copying or assignment are kept until ReleaseRetired(), so that a stale
+ * 	slot pointer held by an unlocked reader (see Dict::Handle) never refers
+ * 	to freed memory.
+*/
+class ValueTable
+{
+	public:
+	/** @brief Owning copy of a tagged value (`std::monostate` marks no value) */
+	using Value = std::variant<std::monostate,int,double,std::string,std::vector<int>,std::vector<double>>;
+	/** @brief Non-owning view of a tagged value, with the alternatives of Value in the same order */
+	using ValueView = std::variant<std::monostate,int,double,std::string_view,Span<const int>,Span<const double>>;
+	/** @brief ValueType viewed as `T` by ViewAs() (one of the alternatives of ValueView) */
+	template <class T>
+	static constexpr ValueType ViewTypeOf = std::is_same_v<T,int> ? ValueType::Int :
+		std::is_same_v<T,double> ? ValueType::Double :
+		std::is_same_v<T,std::string_view> ? ValueType::String :
+		std::is_same_v<T,Span<const int>> ? ValueType::IntArray : ValueType::DoubleArray;
+
+	/** @brief A string stored in the table's arena */
+	struct StringRef
+	{
+		std::uint32_t Offset;
+		std::uint32_t Length;
+	};
+
+	/** @brief A single table slot */
+	struct Slot
+	{
+		std::size_t Hash = 0; ///<Cached hash of the key
+		StringRef Key{};      ///<Lookup key (see ValueTable::KeyOf())
+		unsigned char Tag = 0; ///<ValueType of the value, or 0 if the slot is empty
+		bool Mapped = false;  ///<Array value is the MappedArray numbered `Str.Offset` rather than arena data
+		union
+		{
+			int Int;
+			double Double = 0.0;
+			StringRef Str;    ///<String or array value (see ValueTable::StringOf(), ValueTable::IntsOf())
+			std::uint64_t Bits; ///<The whole value, for copying it in one store (see CopySlot())
+		};
+
+		/** @brief Whether the slot holds no value */
+		bool Empty() const {return Tag == 0;}
+		/** @brief Type of the stored value (only meaningful if not Empty()) */
+		ValueType Type() const {return static_cast<ValueType>(Tag);}
+	};
+
+	ValueTable() = default;
+	/** @brief Shares the values of `T` (retained slot chunks are not copied) */
+	ValueTable(const ValueTable &T) :
+		Slots(T.Slots),
+		Count(T.Count),
+		TypeCount{T.TypeCount[0],T.TypeCount[1],T.TypeCount[2],T.TypeCount[3],T.TypeCount[4],T.TypeCount[5]},
+		Pages(T.Pages),
+		ArenaSize(T.ArenaSize),
+		Interned(T.Interned),
+		InternCount(T.InternCount),
+		Mappings(T.Mappings) {}
+	ValueTable(ValueTable&&) = default;
+	/** @brief Replaces the values with (shared) ones of `T` */
+	ValueTable& operator=(const ValueTable &T);
+	/** @brief Takes the values of `T` (retained slot chunks are kept, and the current ones retired) */
+	ValueTable& operator=(ValueTable &&T);
+
+	/** @brief Returned by Find() when a key is not present */
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	/** @brief Hashes a key */
+	static std::size_t HashKey(std::string_view key);
+
+	/** @brief Finds the slot holding `key` with type `type` */
+	std::size_t Find(std::string_view key, std::size_t hash, ValueType type) const;
+	/** @brief Hints that the slot where the probe sequence of `hash` starts is about to be read */
+	void Prefetch(std::size_t hash) const
+	{
+#if defined(__GNUC__)
+		if (!Slots.empty())
+			__builtin_prefetch(&Slots[hash & (Slots.size() - 1)]);
+#else
+		(void)hash;
+#endif
+	}
+	/** @brief Finds or creates the slot for `key` with type `type` */
+	std::pair<std::size_t,bool> Emplace(std::string_view key, std::size_t hash, ValueType type);
+	/** @brief Removes the value in slot `i` (other values may move to different slots) */
+	void Erase(std::size_t i);
+
+	/** @brief Access a slot by index */
+	Slot const& operator[](std::size_t i) const {return Slots[i];}
+	/** @brief Access a slot by index for writing, unsharing its chunk first */
+	Slot& Mutable(std::size_t i)
+	{
+		if (!Retain)
+			return Slots.Mutable(i,nullptr);
+		std::size_t Before = Retired.size();
+		Slot &S = Slots.Mutable(i,&Retired);
+		RetiredBytes += (Retired.size() - Before) * Slots.ChunkSize() * sizeof(Slot);
+		return S;
+	}
+
+	/** @brief Key of a slot */
+	std::string_view KeyOf(Slot const &S) const {return View(S.Key);}
+	/** @brief String value of a slot */
+	std::string_view StringOf(Slot const &S) const {return View(S.Str);}
+	/** @brief Values of a slot of type ValueType::IntArray (valid until the table is destroyed or assigned to) */
+	Span<const int> IntsOf(Slot const &S) const
+	{
+		if (S.Mapped)
+			return MappingOf(S)->Ints();
+		return Span<const int>(reinterpret_cast<const int*>(Locate(S.Str)),S.Str.Length);
+	}
+	/** @brief Values of a slot of type ValueType::DoubleArray (valid until the table is destroyed or assigned to) */
+	Span<const double> DoublesOf(Slot const &S) const
+	{
+		if (S.Mapped)
+			return MappingOf(S)->Doubles();
+		return Span<const double>(reinterpret_cast<const double*>(Locate(S.Str)),S.Str.Length);
+	}
+	/** @brief Mapped file holding the array of a slot, or `nullptr` if its values are in the arena */
+	MappedArray const* MappingOf(Slot const &S) const {return S.Mapped ? &(*Mappings)[S.Str.Offset] : nullptr;}
+	/** @brief Owning copy of the value of a slot */
+	Value Get(Slot const &S) const;
+	/** @brief View of the value of a slot (valid until the table is destroyed or assigned to) */
+	ValueView ViewOf(Slot const &S) const;
+	/** @brief View of the value of a slot of type ViewTypeOf<T> */
+	template <class T>
+	T ViewAs(Slot const &S) const
+	{
+		if constexpr (std::is_same_v<T,int>)
+			return S.Int;
+		else if constexpr (std::is_same_v<T,double>)
+			return S.Double;
+		else if constexpr (std::is_same_v<T,std::string_view>)
+			return StringOf(S);
+		else if constexpr (std::is_same_v<T,Span<const int>>)
+			return IntsOf(S);
+		else
+			return DoublesOf(S);
+	}
+
+	/**
+	 * @brief Reads a slot field that a Dict::Handle may read while it is being written
+	 *
+	 * The type and value of a slot are read by handles without the lock
+	 * (validated by the dictionary version afterwards), so they are only
+	 * ever read and written through LoadShared() and StoreShared().
+	 */
+	template <class T>
+	static T LoadShared(T const &Field)
+	{
+#if defined(__GNUC__)
+		T V;
+		__atomic_load(&Field,&V,__ATOMIC_RELAXED);
+		return V;
+#else
+		return Field;
+#endif
+	}
+	/** @brief Writes a slot field that a Dict::Handle may be reading (see LoadShared()) */
+	template <class T>
+	static void StoreShared(T &Field, T V)
+	{
+#if defined(__GNUC__)
+		__atomic_store(&Field,&V,__ATOMIC_RELAXED);
+#else
+		Field = V;
+#endif
+	}
+	/** @brief Copies slot `From` to `To`, writing its type and value with StoreShared() */
+	static void CopySlot(Slot &To, Slot const &From)
+	{
+		To.Hash = From.Hash;
+		To.Key = From.Key;
+		To.Mapped = From.Mapped;
+		StoreShared(To.Bits,From.Bits);
+		StoreShared(To.Tag,From.Tag);
+	}
+
+	/** @brief Stores an `int` in a slot of type ValueType::Int */
+	void Set(Slot &S, int val) {StoreShared(S.Int,val);}
+	/** @overload */
+	void Set(Slot &S, double val) {StoreShared(S.Double,val);}
+	/** @brief Stores a string in a slot of type ValueType::String */
+	void Set(Slot &S, std::string_view val) {StoreShared(S.Str,Intern(val,HashKey(val)));}
+	/** @brief Stores an array in a slot of type ValueType::IntArray */
+	void Set(Slot &S, Span<const int> val) {S.Mapped = false; StoreShared(S.Str,AppendArray(val.data(),val.size()));}
+	/** @brief Stores an array in a slot of type ValueType::DoubleArray */
+	void Set(Slot &S, Span<const double> val) {S.Mapped = false; StoreShared(S.Str,AppendArray(val.data(),val.size()));}
+	/** @brief Refers a slot of the array's type to a mapped file (without copying it) */
+	void Set(Slot &S, MappedArray const &val);
+	/** @brief Stores a value of the slot's type */
+	void Set(Slot &S, Value const &val);
+	/** @brief Stores the value of slot `From` of table `T` in `S` (which has its type), without an intermediate copy */
+	void Set(Slot &S, ValueTable const &T, Slot const &From);
+
+	/** @brief Number of slots in the table */
+	std::size_t Capacity() const {return Slots.size();}
+	/** @brief Number of stored values */
+	std::size_t Size() const {return Count;}
+	/** @brief Number of stored values of type `type` */
+	std::size_t Size(ValueType type) const {return TypeCount[static_cast<std::size_t>(type)];}
+	/** @brief Memory held by the table */
+	MemoryStats Memory() const;
+	/** @brief Copy of the table holding only the strings and arrays still referred to
+	 *
+	 * Unlike a copy, which shares the arena, this rebuilds it, dropping the
+	 * space of replaced and erased values.
+	 */
+	ValueTable Compacted() const;
+
+	/** @brief Keep replaced slot chunks alive until ReleaseRetired()
+	 * @note This only affects memory reclamation, hence it may be enabled
+	 * 	through a const reference. */
+	void RetainSlots() const {Retain = true;}
+	/** @brief Whether replaced slot chunks are being kept */
+	bool HasRetired() const {return !Retired.empty();}
+	/** @brief Frees the replaced slot chunks kept since RetainSlots() (no stale slot pointer may be read after this) */
+	void ReleaseRetired()
+	{
+		Retired.clear();
+		Retired.shrink_to_fit();
+		RetiredBytes = 0;
+	}
+
+	private:
+	/** @brief Fixed-size array of `T` split into reference-counted chunks
+	 *
+	 * Copies share the directory of chunks and the chunks themselves.
+	 * Mutable() copies the directory and then the chunk holding the element
+	 * if either is still shared, so a copy is O(1) and each later write
+	 * copies at most one chunk (plus the directory, once).
+	 */
+	template <class T>
+	class Chunked
+	{
+		using Directory = std::vector<std::shared_ptr<T>>;
+		std::shared_ptr<Directory> Dir;
+		std::size_t Length = 0;
+		unsigned Shift = 0; ///<log2 of the chunk size
+
+		static std::shared_ptr<T> Allocate(std::size_t n) {return std::shared_ptr<T>(new T[n](),std::default_delete<T[]>());}
+		/** @brief Replaces the shared chunk `C` by a copy (kept out of the inlined write path) */
+		void Unshare(std::shared_ptr<T> &C, std::vector<std::shared_ptr<T>>* Retired)
+		{
+			std::shared_ptr<T> Copy = Allocate(ChunkSize());
+			std::copy_n(C.get(),ChunkSize(),Copy.get());
+			if (Retired)
+				Retired->push_back(std::move(C));
+			C = std::move(Copy);
+		}
+
+		public:
+		static constexpr unsigned MaxShift = 8; ///<Chunks hold at most 256 elements
+
+		Chunked() = default;
+		/** @brief Creates `n` value-initialized elements (`n` must be a power of two) */
+		explicit Chunked(std::size_t n) : Dir(std::make_shared<Directory>()), Length(n)
+		{
+			while (Shift < MaxShift && (std::size_t(2) << Shift) <= n)
+				Shift++;
+			Dir->reserve(n >> Shift);
+			for (std::size_t c = 0; c < (n >> Shift); c++)
+				Dir->push_back(Allocate(ChunkSize()));
+		}
+
+		std::size_t size() const {return Length;}
+		bool empty() const {return Length == 0;}
+		/** @brief Number of elements per chunk */
+		std::size_t ChunkSize() const {return std::size_t(1) << Shift;}
+		/** @brief Chunks of the array, in order */
+		Directory const& Chunks() const {static const Directory None; return Dir ? *Dir : None;}
+
+		T const& operator[](std::size_t i) const {return (*Dir)[i >> Shift].get()[i & (ChunkSize() - 1)];}
+		/** @brief Access an element of an array that has not been copied yet */
+		T& Unshared(std::size_t i) {return (*Dir)[i >> Shift].get()[i & (ChunkSize() - 1)];}
+		/**
+		 * @param i Index of the element
+		 * @param Retired If not null, receives a chunk replaced by its copy
+		 * @return Element `i`, in a chunk owned by this array alone
+		 */
+		T& Mutable(std::size_t i, std::vector<std::shared_ptr<T>>* Retired)
+		{
+			if (Dir.use_count() > 1)
+				Dir = std::make_shared<Directory>(*Dir);
+			std::shared_ptr<T> &C = (*Dir)[i >> Shift];
+			if (C.use_count() > 1)
+				Unshare(C,Retired);
+			//Order this write after the reads of any owner that released the chunk
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return C.get()[i & (ChunkSize() - 1)];
+		}
+
+		/** @brief Bytes of chunks also referenced by another array */
+		std::size_t SharedBytes() const
+		{
+			std::size_t Bytes = 0;
+			for (std::shared_ptr<T> const &C : Chunks())
+				if (Dir.use_count() > 1 || C.use_count() > 1)
+					Bytes += ChunkSize() * sizeof(T);
+			return Bytes;
+		}
+	};
+
+	/** @brief An entry of the interning index (`Ref.Length` is 0 if unused) */
+	struct InternSlot
+	{
+		std::size_t Hash = 0;
+		StringRef Ref{};
+	};
+
+	/** @brief A page of the arena
+	 *
+	 * A string longer than a page gets a block spanning several pages, each
+	 * of which refers to the whole block and the offset at which it starts.
+	 */
+	struct Page
+	{
+		std::shared_ptr<char> Block;
+		std::uint32_t Base;  ///<Arena offset of the start of `Block`
+	};
+	static constexpr unsigned PageShift = 12;
+	static constexpr std::size_t ArrayAlign = 64; ///<Alignment of arrays in the arena (and of its blocks)
+	static constexpr std::size_t PageSize = std::size_t(1) << PageShift;
+
+	Chunked<Slot> Slots;                ///<Slot array; size is zero or a power of two
+	std::size_t Count = 0;              ///<Number of occupied slots
+	std::size_t TypeCount[6] = {0,0,0,0,0,0}; ///<Number of occupied slots per ValueType
+	std::shared_ptr<std::vector<Page>> Pages; ///<Arena pages holding keys and string values
+	std::size_t ArenaSize = 0;          ///<Next free arena offset
+	Chunked<InternSlot> Interned;       ///<Strings in the arena by hash; size is zero or a power of two
+	std::size_t InternCount = 0;        ///<Number of strings in `Interned`
+	mutable bool Retain = false;        ///<Whether replaced slot chunks are kept
+	std::vector<std::shared_ptr<Slot>> Retired; ///<Replaced slot chunks (if `Retain`)
+	std::size_t RetiredBytes = 0;       ///<Bytes of the chunks in `Retired`
+	std::vector<std::shared_ptr<char>> RetiredPages; ///<Shared pages replaced by a private copy
+	std::shared_ptr<std::vector<MappedArray>> Mappings; ///<Mapped files referred to by slots
+
+	/** @brief Address of arena data (`nullptr` for an empty reference) */
+	const char* Locate(StringRef R) const
+	{
+		if (R.Length == 0)
+			return nullptr;
+		Page const &P = (*Pages)[R.Offset >> PageShift];
+		return P.Block.get() + (R.Offset - P.Base);
+	}
+	/** @brief Text of an arena string */
+	std::string_view View(StringRef R) const {return std::string_view(Locate(R),R.Length);}
+	/** @brief Finds `s` in the arena, appending it if it is not there yet */
+	StringRef Intern(std::string_view s, std::size_t hash);
+	/** @brief Copies `s` to the end of the arena, aligned to `Align` bytes */
+	StringRef Append(std::string_view s, std::size_t Align = 1);
+	/** @brief Copies an array to the arena (the reference holds its element count) */
+	template <class T>
+	StringRef AppendArray(const T* Data, std::size_t n)
+	{
+		if (n == 0)
+			return StringRef();
+		StringRef R = Append(std::string_view(reinterpret_cast<const char*>(Data),n * sizeof(T)),ArrayAlign);
+		R.Length = static_cast<std::uint32_t>(n);
+		return R;
+	}
+	/** @brief Resizes the interning index */
+	void RehashInterned(std::size_t NewCapacity);
+	/** @brief Resizes the slot array and reinserts all values */
+	void Rehash(std::size_t NewCapacity);
+	/** @brief Moves the current slot chunks to `Retired` (if `Retain`) */
+	void RetireSlots();
+};
+
+/** @brief A value that changed when a watched configuration was reloaded */
+struct ConfigChange
+{
+	/** @brief How the value changed */
+	enum class Kind {Added, Modified, Removed};
+	Kind Change;
+	std::string Key;
+	ValueType Type;
+	ValueTable::Value Old; ///<Previous value (`std::monostate` if added)
+	ValueTable::Value New; ///<Current value (`std::monostate` if removed)
+	std::optional<MappedArray> Mapped; ///<File holding `New` if it is a mapped array (applied without copying)
+};
+
+/** @brief A key and a view of its value, as returned by Dict::Prefix() and Dict::Range() */
+struct DictEntry
+{
+	std::string_view Key;
+	ValueType Type;
+	ValueTable::ValueView Value;
+};
+
+/** @brief A key to look up with Dict::GetMany(), and the type of value wanted */
+struct KeyRequest
+{
+	std::string_view Key;
+	ValueType Type;
+	std::size_t Hash = 0; ///<ValueTable::HashKey(Key), if computed ahead of time (0: hashed by GetMany())
+};
+
+/** @brief The value found for a KeyRequest (only the member of the requested type is set) */
+struct KeyResult
+{
+	bool Found = false;
+	int Int = 0;
+	double Double = 0.0;
+	std::string String;
+	Span<const int> Ints;       ///<Valid until the dictionary is destroyed or assigned to
+	Span<const double> Doubles; ///<Valid until the dictionary is destroyed or assigned to
+};
 
 /** @class Dict
  * @brief A class contining information loaded from a configuration file
  * 
- * This class creates a set of unordered maps which translate a `std::string` key
+ * This class holds a single flat hash table which translates a `std::string` key
  * 	into `double`, `int`, or `std::string` values read from an input
  *	configuration file.  
  * @todo It may be beneficial to add separate maps for value enforcement.
@@ -68,93 +860,1205 @@ bool ReadConfig(std::istream &f_in, Dict* D, bool Debug =false);
 */
 class Dict
 {
-	std::unordered_map<std::string,std::string> StringMap;  ///<Dictionary containing strings
-	std::unordered_map<std::string,double> DoubleMap;       ///<Dictionary containing doubles
-	std::unordered_map<std::string,int> IntMap;             ///<Dictionary containing ints
+	ValueTable Table; ///<Dictionary containing all values
 
 	/** @brief Thread access controller */
 	mutable std::mutex DictMutex;
+	/** @brief Modification counter; odd while a write is in progress
+	 *
+	 * Every modification increments the counter once before and once after
+	 * changing the table (while holding DictMutex), which lets Handle
+	 * readers detect a concurrent write without taking the mutex.
+	 */
+	std::atomic<std::uint64_t> Version{0};
+
+	/** @brief Count of Handle reads in progress, on a cache line of its own */
+	struct alignas(64) ReaderCount
+	{
+		std::atomic<unsigned> N{0};
+	};
+	static constexpr std::size_t ReaderStripes = 16;
+	/** @brief Handle reads in progress, spread over stripes by thread (allocated by the first Pin()) */
+	mutable std::unique_ptr<ReaderCount[]> Readers;
+
+	/** @brief Frees replaced slot chunks if no Handle is reading (caller must hold DictMutex, after changing `Version`) */
+	void ReclaimSlots()
+	{
+		if (!Table.HasRetired())
+			return;
+		if (!Readers) { //No handle was ever pinned to this copy
+			Table.ReleaseRetired();
+			return;
+		}
+		//Pairs with the increment in Handle::Get(): either the reader sees the
+		//new version and leaves its slot alone, or it is counted here
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		for (std::size_t i = 0; i < ReaderStripes; i++)
+			if (Readers[i].N.load(std::memory_order_acquire) != 0)
+				return; //Left for a later write
+		Table.ReleaseRetired();
+	}
+
+	/** @brief Marks a write in progress on `Version` (caller must hold DictMutex) */
+	class WriteScope
+	{
+		Dict &D;
+		public:
+		explicit WriteScope(Dict &D_) : D(D_)
+		{
+			D.Version.store(D.Version.load(std::memory_order_relaxed) + 1,std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+		~WriteScope()
+		{
+			D.Version.store(D.Version.load(std::memory_order_relaxed) + 1,std::memory_order_release);
+			D.ReclaimSlots();
+		}
+	};
+
+	/** @brief Holds DictMutex, timing the wait in Stats when it is already held */
+	class LockScope
+	{
+		std::mutex &M;
+		public:
+		explicit LockScope(std::mutex &M_) : M(M_)
+		{
+#ifdef PARSELI_NO_STATS
+			M.lock();
+#else
+			if (!M.try_lock())
+				WaitFor(M);
+#endif
+		}
+		~LockScope() {M.unlock();}
+		LockScope(LockScope const&) = delete;
+		LockScope& operator=(LockScope const&) = delete;
+	};
+	/** @brief Locks `M`, which was found held */
+	static void WaitFor(std::mutex &M);
+
 	public:
 	std::string Filename;
+	template <class T> class Handle;
 	
 	/** @brief Default constructor */
 	Dict() = default;
 	Dict(std::string const &Filename_) : 
-		StringMap(0),
-		DoubleMap(0),
-		IntMap(0),
+		Table(),
 		DictMutex()
 	{
 		ReadConfig(Filename_.c_str(),this);
 	}
 	~Dict() = default;
 	
-	/** @brief Copy constructor */
-	explicit Dict(const Dict &D) : 
-		StringMap(D.StringMap),
-		DoubleMap(D.DoubleMap),
-		IntMap(D.IntMap),
-		DictMutex(),
-		Filename(D.Filename) {}
+	/** @brief Copy constructor
+	 *
+	 * The copy shares its values with `D` until either is modified, so
+	 * copying is O(1) and a modification copies only the chunk it touches.
+	 */
+	explicit Dict(const Dict &D) : Dict()
+	{
+		LockScope lock(D.DictMutex);
+		Table = D.Table;
+		Filename = D.Filename;
+		StaleArena = D.StaleArena;
+	}
 	
-	/** @brief Assignment operator */
+	/** @brief Assignment operator (shares the values of `D` like the copy constructor) */
 	Dict& operator=(const Dict &D)
 	{
 		if (this != &D) {
 			//Lock both mutexes when ready
 			std::lock(DictMutex,D.DictMutex);
 			std::lock_guard<std::mutex> L_local(DictMutex, std::adopt_lock);
-			std::lock_guard<std::mutex> L_D(DictMutex, std::adopt_lock);
-			StringMap = D.StringMap;
-			DoubleMap = D.DoubleMap;
-			IntMap = D.IntMap;
+			std::lock_guard<std::mutex> L_D(D.DictMutex, std::adopt_lock);
+			WriteScope W(*this);
+			Table = D.Table;
 			Filename = D.Filename;
+			StaleArena = D.StaleArena;
 		}
 		return *this;
 	}
 	
 	/** @brief Add a `double` to the dictionary map */
-	bool add(std::string const &key, double val);
+	bool add(std::string_view key, double val);
 	/** @overload bool add(std::string key, int val); */
-	bool add(std::string const &key, int val);
+	bool add(std::string_view key, int val);
 	/** @overload bool add(std::string key, std::string val); */
-	bool add(std::string const &key, std::string const &val);
+	bool add(std::string_view key, std::string_view val);
+	/** @overload bool add(std::string key, Span<const int> val); */
+	bool add(std::string_view key, Span<const int> val);
+	/** @overload bool add(std::string key, Span<const double> val); */
+	bool add(std::string_view key, Span<const double> val);
+	/** @overload bool add(std::string key, MappedArray const &val); */
+	bool add(std::string_view key, MappedArray const &val);
 
 	/** @brief Add a `double` to the dictionary map, overwrite if it already exists */
-	void set(std::string const &key, double val);
+	void set(std::string_view key, double val);
 	/** @overload bool add(std::string key, int val); */
-	void set(std::string const &key, int val);
+	void set(std::string_view key, int val);
 	/** @overload bool add(std::string key, std::string val); */
-	void set(std::string const &key, std::string const &val);
+	void set(std::string_view key, std::string_view val);
+	/** @overload bool add(std::string key, Span<const int> val); */
+	void set(std::string_view key, Span<const int> val);
+	/** @overload bool add(std::string key, Span<const double> val); */
+	void set(std::string_view key, Span<const double> val);
+	/** @overload bool add(std::string key, MappedArray const &val); */
+	void set(std::string_view key, MappedArray const &val);
 
 	/** @brief Add a `double` to the dictionary map, overwrite if it already exists */
-	void try_set(std::string const &key, double val);
+	void try_set(std::string_view key, double val);
 	/** @overload bool add(std::string key, int val); */
-	void try_set(std::string const &key, int val);
+	void try_set(std::string_view key, int val);
 	/** @overload bool add(std::string key, std::string val); */
-	void try_set(std::string const &key, std::string const &val);
+	void try_set(std::string_view key, std::string_view val);
+	/** @overload bool add(std::string key, Span<const int> val); */
+	void try_set(std::string_view key, Span<const int> val);
+	/** @overload bool add(std::string key, Span<const double> val); */
+	void try_set(std::string_view key, Span<const double> val);
+	/** @overload bool add(std::string key, MappedArray const &val); */
+	void try_set(std::string_view key, MappedArray const &val);
 
 	/** @brief Get the double corresponding to `key` */
-	double GetDouble(std::string const &key) const;
+	double GetDouble(std::string_view key) const;
 	/** @brief Get the int corresponding to `key` */
-	int GetInt(std::string const &key) const;
+	int GetInt(std::string_view key) const;
 	/** @brief Get the string corresponding to `key` */
-	std::string GetString(std::string const &key) const;
+	std::string GetString(std::string_view key) const;
 	/** @brief Get a boolean from strings map */
-	bool GetBool(std::string const &key) const;
+	bool GetBool(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key` (valid until the Dict is destroyed or assigned to) */
+	Span<const int> GetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key` (valid until the Dict is destroyed or assigned to) */
+	Span<const double> GetDoubleArray(std::string_view key) const;
+
+	/** @brief Get the double corresponding to `key`, if any */
+	std::optional<double> TryGetDouble(std::string_view key) const;
+	/** @brief Get the int corresponding to `key`, if any */
+	std::optional<int> TryGetInt(std::string_view key) const;
+	/** @brief Get the string corresponding to `key`, if any */
+	std::optional<std::string> TryGetString(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key`, if any */
+	std::optional<Span<const int>> TryGetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key`, if any */
+	std::optional<Span<const double>> TryGetDoubleArray(std::string_view key) const;
+	/** @brief Get a boolean from strings map, if `key` holds "true" or "false" */
+	std::optional<bool> TryGetBool(std::string_view key) const;
+	/** @brief Look up every key in `Keys` under a single lock, filling `Out` (returns the number found) */
+	std::size_t GetMany(Span<const KeyRequest> Keys, Span<KeyResult> Out) const;
+
+	/** @brief Get the double corresponding to `key`, or `def` if there is none */
+	double GetOr(std::string_view key, double def) const;
+	/** @overload */
+	int GetOr(std::string_view key, int def) const;
+	/** @overload */
+	std::string GetOr(std::string_view key, std::string const &def) const;
+	/** @overload */
+	std::string GetOr(std::string_view key, const char* def) const;
+	/** @overload */
+	bool GetOr(std::string_view key, bool def) const;
 	
-	/** @brief Check if `key` exists in `double`s map */
-	bool CheckDouble(std::string const &key) const;
-	/** @brief Check if `key` exists in `int`s map*/
-	bool CheckInt(std::string const &key) const;
-	/** @brief Check if `key` exists in `std::string`s map */
-	bool CheckString(std::string const &key) const;
+	/** @brief Check if `key` exists as a `double` */
+	bool CheckDouble(std::string_view key) const;
+	/** @brief Check if `key` exists as an `int` */
+	bool CheckInt(std::string_view key) const;
+	/** @brief Check if `key` exists as a `std::string` */
+	bool CheckString(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `int` */
+	bool CheckIntArray(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `double` */
+	bool CheckDoubleArray(std::string_view key) const;
+
+	/** @brief Remove `key` (of every type) from the dictionary */
+	bool erase(std::string_view key);
+	/** @brief Remove `key` of type `type` from the dictionary */
+	bool erase(std::string_view key, ValueType type);
 
 	/** @brief Prints information about loaded dictionary to stdout */
 	void Dump() const;
+	/** @brief Memory held by the dictionary's values */
+	MemoryStats Memory() const;
+
+	/** @brief Creates an immutable snapshot of the dictionary (with a perfect hash of its keys if `PerfectHash`) */
+	std::shared_ptr<const FrozenDict> Freeze(bool PerfectHash = false) const;
+
+	/** @brief Every value whose key starts with `prefix`, in key order (views valid until the next write) */
+	std::vector<DictEntry> Prefix(std::string_view prefix) const;
+	/** @brief Every value viewed as `T` whose key starts with `prefix`, in key order (views valid until the next write) */
+	template <class T>
+	std::vector<std::pair<std::string_view,T>> Prefix(std::string_view prefix) const;
+	/** @brief Every value whose key lies in [`first`, `last`), in key order (views valid until the next write) */
+	std::vector<DictEntry> Range(std::string_view first, std::string_view last) const;
+	/** @brief Every value viewed as `T` whose key lies in [`first`, `last`), in key order (views valid until the next write) */
+	template <class T>
+	std::vector<std::pair<std::string_view,T>> Range(std::string_view first, std::string_view last) const;
+
+	/** @brief Resolves `key` once into a typed handle for repeated reads */
+	template <class T>
+	Handle<T> GetHandle(std::string_view key) const {return Handle<T>(this,std::string(key));}
+
+	private:
+	/** @brief Finds `key` with type `type` for a lookup of kind `kind` (caller must hold DictMutex) */
+	ValueTable::Slot const* Lookup(std::string_view key, ValueType type, LookupKind kind) const;
+	/** @brief Inserts `key` with type `type` (caller must hold DictMutex)
+	 * @return The slot for `key` and whether it was newly created */
+	std::pair<ValueTable::Slot*,bool> Insert(std::string_view key, ValueType type);
+	/** @brief Stores `val` under `key` unless it is already present with type `type`
+	 * @return `True` if the value was added */
+	template <class T>
+	bool AddNew(std::string_view key, ValueType type, T const &val);
+	/** @brief Resolves `key` for a Handle and copies its value under the lock */
+	ValueTable::Slot const* Pin(std::string const &key, ValueType type, std::uint64_t &Seen, ValueTable::Value &Out, std::atomic<unsigned>* &Reading) const;
+	/** @brief Reads a slot pinned by a Handle under the lock */
+	bool ReadPinned(ValueTable::Slot const* S, std::uint64_t Seen, ValueTable::Value &Out) const;
+	/** @brief Reports a missing key for a Handle and throws */
+	[[noreturn]] void HandleMiss(std::string const &key, ValueType type) const;
+
+	/** @brief Occupied slots sorted by key and type, built by Sorted() */
+	mutable std::vector<std::size_t> SortedSlots;
+	/** @brief Version at which `SortedSlots` was built (odd: never) */
+	mutable std::uint64_t SortedVersion = 1;
+	/** @brief Sorted index of the table, rebuilt if the dictionary changed (caller must hold DictMutex) */
+	std::vector<std::size_t> const& Sorted() const;
+	/** @brief Values in key order from `first` while the key matches `prefix` or is below `last` */
+	template <class Out>
+	void Scan(std::string_view first, std::string_view last, bool prefix, Out&& Emit) const;
+
+	friend class ConfigWatcher;
+	friend class ConcurrentDict;
+	/** @brief Arena bytes of values replaced or removed by ApplyChanges() since the arena was last compacted */
+	std::size_t StaleArena = 0;
+	/** @brief Applies the changes of a reload under a single lock (compacting the arena once enough of it is stale) */
+	void ApplyChanges(std::vector<ConfigChange> const &Changes);
+};
+
+/** @class Dict::Handle
+ * @brief A key resolved once for repeated reads of an `int`, `double` or `std::string`
+ *
+ * A handle remembers where its value is stored in the dictionary and the
+ * dictionary version at which it looked, so Get() reads by direct index
+ * without building a key, hashing or locking.  Any modification of the
+ * dictionary changes the version; the next Get() then re-resolves the key
+ * under the mutex.  `std::string` handles skip the hash but still read
+ * under the mutex, since a string may be reallocated by a concurrent set().
+ * @note A handle must not outlive its Dict.  Handles are cheap to copy;
+ * 	give each thread its own copy rather than sharing one.
+*/
+template <class T>
+class Dict::Handle
+{
+	static_assert(std::is_same_v<T,int> || std::is_same_v<T,double> || std::is_same_v<T,std::string>,
+		"Dict::Handle supports int, double and std::string");
+	static constexpr ValueType Type = std::is_same_v<T,int> ? ValueType::Int :
+		(std::is_same_v<T,double> ? ValueType::Double : ValueType::String);
+
+	Dict const* Owner = nullptr;
+	std::string Key;
+	ValueTable::Slot const* Pinned = nullptr;
+	std::uint64_t Seen = 1; ///<Dictionary version at resolution (odd: unresolved)
+	std::atomic<unsigned>* Reading = nullptr; ///<Counter of reads in progress (see Dict::ReclaimSlots())
+
+	/** @brief Re-resolves the key under the dictionary mutex */
+	T Refresh()
+	{
+		ValueTable::Value Out;
+		Pinned = Owner->Pin(Key,Type,Seen,Out,Reading);
+		if (!Pinned)
+			Owner->HandleMiss(Key,Type);
+		return std::get<T>(std::move(Out));
+	}
+
+	public:
+	/** @brief Creates an unbound handle */
+	Handle() = default;
+	/** @brief Creates a handle for `key_` in `D` (resolved on first use) */
+	Handle(Dict const* D, std::string key_) : Owner(D), Key(std::move(key_)) {}
+
+	/** @brief Key this handle refers to */
+	std::string const& GetKey() const {return Key;}
+
+	/**
+	 * @return Current value of the key
+	 * @throw std::out_of_range if the key does not exist with this type
+	 */
+	T Get()
+	{
+		if constexpr (std::is_same_v<T,std::string>) {
+			ValueTable::Value Out;
+			if (Pinned && Owner->ReadPinned(Pinned,Seen,Out))
+				return std::get<T>(std::move(Out));
+		} else {
+			//Seqlock read: the slot may be written meanwhile, so its fields are read
+			//atomically and the value is only used if the version did not change.
+			//While counted in `Reading`, the slot's chunk is not freed.
+			if (Pinned) {
+				Reading->fetch_add(1,std::memory_order_seq_cst);
+				std::uint64_t v = Owner->Version.load(std::memory_order_seq_cst);
+				bool Valid = (v == Seen && static_cast<ValueType>(ValueTable::LoadShared(Pinned->Tag)) == Type);
+				T val{};
+				if (Valid) {
+					if constexpr (std::is_same_v<T,int>)
+						val = ValueTable::LoadShared(Pinned->Int);
+					else
+						val = ValueTable::LoadShared(Pinned->Double);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					Valid = (Owner->Version.load(std::memory_order_relaxed) == v);
+				}
+				Reading->fetch_sub(1,std::memory_order_release);
+				if (Valid)
+					return val;
+			}
+		}
+		return Refresh();
+	}
 };
+
+/**
+ * @param first Lowest key to return, or the prefix of all keys to return
+ * @param last Key above the last one to return (ignored if `prefix`)
+ * @param prefix Whether to return the keys starting with `first`
+ * @param Emit Called with the key and slot of each value, under the lock
+ */
+template <class Out>
+void Dict::Scan(std::string_view first, std::string_view last, bool prefix, Out&& Emit) const
+{
+	LockScope lock(DictMutex);
+	std::vector<std::size_t> const &Index = Sorted();
+	auto i = std::lower_bound(Index.begin(),Index.end(),first,[this](std::size_t s, std::string_view key) {
+		return Table.KeyOf(Table[s]) < key;
+	});
+	for (; i != Index.end(); ++i) {
+		ValueTable::Slot const &S = Table[*i];
+		std::string_view key = Table.KeyOf(S);
+		if (prefix ? key.substr(0,first.length()) != first : key >= last)
+			break;
+		Emit(key,S);
+	}
+}
+
+/**
+ * @tparam T `int`, `double`, `std::string_view`, `Span<const int>` or `Span<const double>`
+ * @param prefix Start of the keys to return
+ * @return Key and value of each value of type `T` whose key starts with `prefix`,
+ * 	viewing the dictionary's storage (valid until it is next written)
+ */
+template <class T>
+std::vector<std::pair<std::string_view,T>> Dict::Prefix(std::string_view prefix) const
+{
+	constexpr unsigned char Tag = static_cast<unsigned char>(ValueTable::ViewTypeOf<T>);
+	static_assert(std::is_same_v<std::variant_alternative_t<Tag,ValueTable::ValueView>,T>,"Dict::Prefix views int, double, std::string_view and Span values");
+	std::vector<std::pair<std::string_view,T>> Out;
+	Scan(prefix,std::string_view(),true,[&](std::string_view key, ValueTable::Slot const &S) {
+		if (S.Tag == Tag)
+			Out.emplace_back(key,Table.ViewAs<T>(S));
+	});
+	return Out;
+}
+
+/**
+ * @tparam T `int`, `double`, `std::string_view`, `Span<const int>` or `Span<const double>`
+ * @param first Lowest key to return
+ * @param last Key above the last one to return
+ * @return Key and value of each value of type `T` whose key lies in [`first`, `last`),
+ * 	viewing the dictionary's storage (valid until it is next written)
+ */
+template <class T>
+std::vector<std::pair<std::string_view,T>> Dict::Range(std::string_view first, std::string_view last) const
+{
+	constexpr unsigned char Tag = static_cast<unsigned char>(ValueTable::ViewTypeOf<T>);
+	static_assert(std::is_same_v<std::variant_alternative_t<Tag,ValueTable::ValueView>,T>,"Dict::Range views int, double, std::string_view and Span values");
+	std::vector<std::pair<std::string_view,T>> Out;
+	Scan(first,last,false,[&](std::string_view key, ValueTable::Slot const &S) {
+		if (S.Tag == Tag)
+			Out.emplace_back(key,Table.ViewAs<T>(S));
+	});
+	return Out;
+}
 /** @} */
 
+/** @name Minimal perfect hashing
+ * A fixed set of `n` distinct 64-bit hashes is mapped one-to-one onto the
+ * positions `0` to `n - 1` by hash and displace: each hash falls into one
+ * of PerfectBuckets(n) buckets, and each bucket gets a seed, chosen
+ * largest bucket first, that places all of its hashes on positions no
+ * other bucket uses.  Finding a key then takes one hash of the key, two
+ * mixes of that hash and a single comparison with the key at its position.
+ * FrozenDict builds one over its keys at runtime and Schema over its keys
+ * at compile time.
+ * @{
+ */
+/** @brief Mixes a hash with a seed (the 64-bit finalizer of MurmurHash3) */
+constexpr std::uint64_t PerfectMix(std::uint64_t h, std::uint64_t seed)
+{
+	h ^= seed * 0x9e3779b97f4a7c15ull;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+/** @brief Maps a mixed hash onto `0` to `n - 1` (by a multiplication rather than a division where 128-bit integers exist) */
+constexpr std::size_t PerfectReduce(std::uint64_t h, std::size_t n)
+{
+#if defined(__SIZEOF_INT128__)
+	__extension__ using Wide = unsigned __int128;
+	return static_cast<std::size_t>((static_cast<Wide>(h) * n) >> 64);
+#else
+	return static_cast<std::size_t>(h % n);
+#endif
+}
+
+/** @brief Number of buckets of a perfect hash of `n` hashes (about four per bucket) */
+constexpr std::size_t PerfectBuckets(std::size_t n) {return n / 4 + 1;}
+
+/** @brief Position of `h` in the perfect hash of `n` hashes with seeds `Seeds` */
+constexpr std::size_t PerfectSlot(std::uint64_t h, std::uint32_t const* Seeds, std::size_t n)
+{
+	return PerfectReduce(PerfectMix(h,Seeds[PerfectReduce(PerfectMix(h,0),PerfectBuckets(n))]),n);
+}
+
+/**
+ * @brief Chooses the seeds of a perfect hash
+ * @param Hashes        The `n` hashes to place
+ * @param n             Number of hashes (at least one)
+ * @param Seeds         Receives the PerfectBuckets(n) seeds
+ * @param Order         Scratch space for `n` indices
+ * @param Start         Scratch space for PerfectBuckets(n) + 1 indices
+ * @param Taken         Scratch space for `n` flags, all `false`
+ * @return `False` if two of the hashes are equal
+ * @note The scratch space is supplied by the caller so that a perfect hash
+ * 	can be built in a constant expression.
+ */
+constexpr bool BuildPerfectHash(std::uint64_t const* Hashes, std::size_t n, std::uint32_t* Seeds, std::size_t* Order, std::size_t* Start, bool* Taken)
+{
+	std::size_t m = PerfectBuckets(n);
+	//Sort the hashes by bucket; bucket b then spans [Start[b - 1], Start[b]) of Order
+	for (std::size_t b = 0; b <= m; b++)
+		Start[b] = 0;
+	for (std::size_t i = 0; i < n; i++)
+		Start[PerfectReduce(PerfectMix(Hashes[i],0),m) + 1]++;
+	std::size_t Largest = 0;
+	for (std::size_t b = 0; b < m; b++) {
+		Largest = (Start[b + 1] > Largest) ? Start[b + 1] : Largest;
+		Start[b + 1] += Start[b];
+	}
+	for (std::size_t i = 0; i < n; i++)
+		Order[Start[PerfectReduce(PerfectMix(Hashes[i],0),m)]++] = i;
+
+	for (std::size_t Size = Largest; Size > 0; Size--) {
+		for (std::size_t b = 0; b < m; b++) {
+			std::size_t First = b ? Start[b - 1] : 0;
+			if (Start[b] - First != Size)
+				continue;
+			for (std::size_t i = First; i < Start[b]; i++)
+				for (std::size_t j = First; j < i; j++)
+					if (Hashes[Order[i]] == Hashes[Order[j]])
+						return false;
+			//Distinct hashes eventually land on free, distinct positions
+			for (std::uint32_t Seed = 1; ; Seed++) {
+				bool Fits = true;
+				for (std::size_t i = First; i < Start[b] && Fits; i++) {
+					std::size_t p = PerfectReduce(PerfectMix(Hashes[Order[i]],Seed),n);
+					Fits = !Taken[p];
+					for (std::size_t j = First; j < i && Fits; j++)
+						Fits = (PerfectReduce(PerfectMix(Hashes[Order[j]],Seed),n) != p);
+				}
+				if (Fits) {
+					for (std::size_t i = First; i < Start[b]; i++)
+						Taken[PerfectReduce(PerfectMix(Hashes[Order[i]],Seed),n)] = true;
+					Seeds[b] = Seed;
+					break;
+				}
+			}
+		}
+	}
+	for (std::size_t b = 0; b < m; b++)
+		if (Start[b] == (b ? Start[b - 1] : 0))
+			Seeds[b] = 1; //Empty bucket
+	return true;
+}
+/** @} */
+
+/** @class FrozenDict
+ * @brief An immutable snapshot of a Dict
+ *
+ * A FrozenDict is created by Dict::Freeze() and cannot be modified
+ * afterwards, so its getters never lock and may be called from any number
+ * of threads at once.  It shares its values with the Dict it was taken from
+ * until that Dict is modified, so freezing costs O(1).
+ *
+ * Since the keys of a snapshot never change, a minimal perfect hash of
+ * them can be built when it is frozen (Dict::Freeze(true)).  Its values are
+ * then copied to a dense array in which each key has exactly one position,
+ * so a lookup is one hash, one probe and one key comparison, whatever the
+ * number of keys.  Building it takes time and memory linear in the number
+ * of values, instead of the O(1) of a plain snapshot.
+*/
+class FrozenDict
+{
+	ValueTable Table; ///<Dictionary containing all values
+	std::vector<ValueTable::Slot> Dense; ///<Slots by position in the perfect hash (empty if there is none)
+	std::vector<std::uint32_t> Seeds;    ///<Seeds of the perfect hash
+	/** @brief Hash under which the perfect hash places a slot (a key has one entry per type) */
+	static std::uint64_t EntryHash(std::size_t hash, ValueType type) {return hash + static_cast<std::uint64_t>(type) * 0x9e3779b97f4a7c15ull;}
+	/** @brief Slot holding `key` with type `type` for a lookup of kind `kind`, or `nullptr` */
+	ValueTable::Slot const* Find(std::string_view key, ValueType type, LookupKind kind) const;
+	public:
+	std::string Filename;
+
+	/** @brief Creates an empty snapshot */
+	FrozenDict() = default;
+	/** @brief Creates a snapshot holding `Table_`, with a perfect hash of its keys if `PerfectHash` */
+	FrozenDict(ValueTable Table_, std::string Filename_, bool PerfectHash = false);
+
+	/** @brief Whether lookups use a perfect hash */
+	bool Perfect() const {return !Dense.empty();}
+
+	/** @brief Get the double corresponding to `key` */
+	double GetDouble(std::string_view key) const;
+	/** @brief Get the int corresponding to `key` */
+	int GetInt(std::string_view key) const;
+	/** @brief Get the string corresponding to `key` */
+	std::string_view GetString(std::string_view key) const;
+	/** @brief Get a boolean from strings map */
+	bool GetBool(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key` */
+	Span<const int> GetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key` */
+	Span<const double> GetDoubleArray(std::string_view key) const;
+
+	/** @brief Get the double corresponding to `key`, if any */
+	std::optional<double> TryGetDouble(std::string_view key) const;
+	/** @brief Get the int corresponding to `key`, if any */
+	std::optional<int> TryGetInt(std::string_view key) const;
+	/** @brief Get the string corresponding to `key`, if any */
+	std::optional<std::string_view> TryGetString(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key`, if any */
+	std::optional<Span<const int>> TryGetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key`, if any */
+	std::optional<Span<const double>> TryGetDoubleArray(std::string_view key) const;
+	/** @brief Get a boolean from strings map, if `key` holds "true" or "false" */
+	std::optional<bool> TryGetBool(std::string_view key) const;
+
+	/** @brief Get the double corresponding to `key`, or `def` if there is none */
+	double GetOr(std::string_view key, double def) const;
+	/** @overload */
+	int GetOr(std::string_view key, int def) const;
+	/** @overload */
+	std::string_view GetOr(std::string_view key, std::string_view def) const;
+	/** @overload */
+	std::string_view GetOr(std::string_view key, const char* def) const;
+	/** @overload */
+	bool GetOr(std::string_view key, bool def) const;
+
+	/** @brief Check if `key` exists as a `double` */
+	bool CheckDouble(std::string_view key) const;
+	/** @brief Check if `key` exists as an `int` */
+	bool CheckInt(std::string_view key) const;
+	/** @brief Check if `key` exists as a `std::string` */
+	bool CheckString(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `int` */
+	bool CheckIntArray(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `double` */
+	bool CheckDoubleArray(std::string_view key) const;
+
+	/** @brief Prints information about the snapshot to stdout */
+	void Dump() const;
+	/** @brief Memory held by the snapshot's values (and its perfect hash) */
+	MemoryStats Memory() const;
+};
+
+/** @class ConcurrentDict
+ * @brief A dictionary for values written and read by many threads at once
+ *
+ * Every access to a Dict takes its single mutex, so threads updating
+ * unrelated keys at runtime (e.g. adaptive solver parameters) wait for each
+ * other.  A ConcurrentDict stripes its keys over shards chosen by hash, each
+ * a separate table behind its own reader-writer lock: writes to keys in
+ * different shards proceed in parallel, and a read only excludes writes to
+ * its own shard.
+ *
+ * Load a configuration into a Dict and construct a ConcurrentDict from it
+ * (or add the values directly).  Freeze() takes a consistent snapshot of all
+ * shards, e.g. to publish through a SnapshotPublisher.
+ * @note Prefix and range queries, handles and ConfigWatcher are only
+ * 	available on Dict.
+*/
+class ConcurrentDict
+{
+	/** @brief One stripe of the dictionary (aligned so that neighbouring locks do not share a cache line) */
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex Mutex;
+		ValueTable Table;
+	};
+	std::unique_ptr<Shard[]> Shards;
+	std::size_t ShardMask = 0; ///<Number of shards minus one
+	unsigned ShardShift = 0;   ///<Position of the hash bits selecting a shard
+
+	/** @brief Shard holding keys with hash `hash`
+	 *
+	 * The shard is chosen by the bits just below the top of the hash, since
+	 * each table probes from the lowest bits.
+	 */
+	Shard& ShardOf(std::size_t hash) const {return Shards[(hash >> ShardShift) & ShardMask];}
+	/** @brief Stores `val` under `key`, replacing an existing value if `overwrite`
+	 * @return Whether `key` was newly created */
+	template <class T>
+	bool Store(std::string_view key, ValueType type, T const &val, bool overwrite);
+	/** @brief Calls `f` with the table and slot holding `key` under its shard's shared lock
+	 * @return `False` if `key` does not exist with type `type` */
+	template <class F>
+	bool Visit(std::string_view key, ValueType type, LookupKind kind, F &&f) const;
+
+	public:
+	std::string Filename;
+
+	/** @brief Creates an empty dictionary with `ShardCount` shards (rounded up to a power of two) */
+	explicit ConcurrentDict(unsigned ShardCount = 64);
+	/** @brief Creates a dictionary holding a copy of the values of `D` */
+	explicit ConcurrentDict(Dict const &D, unsigned ShardCount = 64);
+	ConcurrentDict(const ConcurrentDict&) = delete;
+	ConcurrentDict& operator=(const ConcurrentDict&) = delete;
+
+	/** @brief Add a `double` to the dictionary map */
+	bool add(std::string_view key, double val);
+	/** @overload bool add(std::string key, int val); */
+	bool add(std::string_view key, int val);
+	/** @overload bool add(std::string key, std::string val); */
+	bool add(std::string_view key, std::string_view val);
+	/** @overload bool add(std::string key, Span<const int> val); */
+	bool add(std::string_view key, Span<const int> val);
+	/** @overload bool add(std::string key, Span<const double> val); */
+	bool add(std::string_view key, Span<const double> val);
+
+	/** @brief Add a `double` to the dictionary map, overwrite if it already exists */
+	void set(std::string_view key, double val);
+	/** @overload bool add(std::string key, int val); */
+	void set(std::string_view key, int val);
+	/** @overload bool add(std::string key, std::string val); */
+	void set(std::string_view key, std::string_view val);
+	/** @overload bool add(std::string key, Span<const int> val); */
+	void set(std::string_view key, Span<const int> val);
+	/** @overload bool add(std::string key, Span<const double> val); */
+	void set(std::string_view key, Span<const double> val);
+
+	/** @brief Add a `double` to the dictionary map unless it already exists */
+	void try_set(std::string_view key, double val) {add(key,val);}
+	/** @overload */
+	void try_set(std::string_view key, int val) {add(key,val);}
+	/** @overload */
+	void try_set(std::string_view key, std::string_view val) {add(key,val);}
+	/** @overload */
+	void try_set(std::string_view key, Span<const int> val) {add(key,val);}
+	/** @overload */
+	void try_set(std::string_view key, Span<const double> val) {add(key,val);}
+
+	/** @brief Get the double corresponding to `key` */
+	double GetDouble(std::string_view key) const;
+	/** @brief Get the int corresponding to `key` */
+	int GetInt(std::string_view key) const;
+	/** @brief Get the string corresponding to `key` */
+	std::string GetString(std::string_view key) const;
+	/** @brief Get a boolean from strings map */
+	bool GetBool(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key` (valid until the dictionary is destroyed) */
+	Span<const int> GetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key` (valid until the dictionary is destroyed) */
+	Span<const double> GetDoubleArray(std::string_view key) const;
+
+	/** @brief Get the double corresponding to `key`, if any */
+	std::optional<double> TryGetDouble(std::string_view key) const;
+	/** @brief Get the int corresponding to `key`, if any */
+	std::optional<int> TryGetInt(std::string_view key) const;
+	/** @brief Get the string corresponding to `key`, if any */
+	std::optional<std::string> TryGetString(std::string_view key) const;
+	/** @brief Get the int array corresponding to `key`, if any */
+	std::optional<Span<const int>> TryGetIntArray(std::string_view key) const;
+	/** @brief Get the double array corresponding to `key`, if any */
+	std::optional<Span<const double>> TryGetDoubleArray(std::string_view key) const;
+	/** @brief Get a boolean from strings map, if `key` holds "true" or "false" */
+	std::optional<bool> TryGetBool(std::string_view key) const;
+
+	/** @brief Get the double corresponding to `key`, or `def` if there is none */
+	double GetOr(std::string_view key, double def) const {return TryGetDouble(key).value_or(def);}
+	/** @overload */
+	int GetOr(std::string_view key, int def) const {return TryGetInt(key).value_or(def);}
+	/** @overload */
+	std::string GetOr(std::string_view key, std::string const &def) const {return TryGetString(key).value_or(def);}
+	/** @overload */
+	std::string GetOr(std::string_view key, const char* def) const {return TryGetString(key).value_or(std::string(def));}
+	/** @overload */
+	bool GetOr(std::string_view key, bool def) const {return TryGetBool(key).value_or(def);}
+
+	/** @brief Check if `key` exists as a `double` */
+	bool CheckDouble(std::string_view key) const;
+	/** @brief Check if `key` exists as an `int` */
+	bool CheckInt(std::string_view key) const;
+	/** @brief Check if `key` exists as a `std::string` */
+	bool CheckString(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `int` */
+	bool CheckIntArray(std::string_view key) const;
+	/** @brief Check if `key` exists as an array of `double` */
+	bool CheckDoubleArray(std::string_view key) const;
+
+	/** @brief Remove `key` (of every type) from the dictionary */
+	bool erase(std::string_view key);
+	/** @brief Remove `key` of type `type` from the dictionary */
+	bool erase(std::string_view key, ValueType type);
+
+	/** @brief Prints information about the dictionary to stdout */
+	void Dump() const;
+	/** @brief Memory held by the dictionary's values (summed over its shards) */
+	MemoryStats Memory() const;
+	/** @brief Creates an immutable snapshot of the dictionary, consistent across shards (see Dict::Freeze()) */
+	std::shared_ptr<const FrozenDict> Freeze(bool PerfectHash = false) const;
+};
+
+/** @class SnapshotPublisher
+ * @brief Atomically publishes FrozenDict snapshots to concurrent readers
+ *
+ * Readers call Acquire() and keep the returned pointer for as long as they
+ * need a consistent configuration; a writer calls Publish() to replace it.
+ * Neither side ever takes a Dict mutex, and a snapshot is released once the
+ * last reader holding it lets go (read-copy-update).
+ * @note The pointer exchange uses the `std::shared_ptr` atomic functions,
+ * 	which standard libraries may implement with a short internal spin
+ * 	lock held only while the pointer itself is copied.
+*/
+class SnapshotPublisher
+{
+	std::shared_ptr<const FrozenDict> Current;
+	public:
+	/** @brief Starts with an empty snapshot */
+	SnapshotPublisher() : Current(std::make_shared<const FrozenDict>()) {}
+	/** @brief Starts with `Initial` */
+	explicit SnapshotPublisher(std::shared_ptr<const FrozenDict> Initial) : Current(std::move(Initial)) {}
+	SnapshotPublisher(const SnapshotPublisher&) = delete;
+	SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+	/** @brief Returns the most recently published snapshot */
+	std::shared_ptr<const FrozenDict> Acquire() const
+	{
+		return std::atomic_load_explicit(&Current,std::memory_order_acquire);
+	}
+
+	/** @brief Replaces the published snapshot with `Next` */
+	void Publish(std::shared_ptr<const FrozenDict> Next)
+	{
+		std::atomic_store_explicit(&Current,std::move(Next),std::memory_order_release);
+	}
+
+	/** @brief Freezes `D` and publishes the result */
+	void Publish(Dict const &D) {Publish(D.Freeze());}
+};
+
+/** @class ConfigWatcher
+ * @brief Keeps a Dict in step with a configuration file and everything it includes
+ *
+ * The watcher reads the file into its Dict, then (on Linux) watches the
+ * file and its includes through inotify.  When one of them changes only
+ * that file is parsed again; the result is compared with the previous
+ * configuration key by key and just the differences are written to the
+ * Dict, under a single lock.  Each difference is reported to the callbacks
+ * registered for its key, and a new snapshot can be published to a
+ * SnapshotPublisher after every change.
+ * @note A reload that fails (the top file cannot be read, a parse error or
+ * 	a failed `enforce`) leaves the Dict as it was.
+ * @note Values present in both the configuration and the Dict are
+ * 	overwritten; keys added to the Dict by other means are left alone.
+ * @note Relative paths are resolved against the working directory at the
+ * 	time of construction.  Where inotify is unavailable Poll() falls back to
+ * 	comparing file sizes and modification times.
+ * @note Strings and arrays replaced by a reload are left in the Dict's arena
+ * 	until enough of it is stale; the Dict is then compacted, which (like an
+ * 	assignment) invalidates arrays previously returned by it.
+*/
+class ConfigWatcher
+{
+	public:
+	/** @brief Called with each change to the configuration */
+	using Callback = std::function<void(ConfigChange const&)>;
+
+	/** @brief Reads `filename` into `D` and starts watching it (only `Options.Debug` applies) */
+	ConfigWatcher(std::string const &filename, Dict* D, ReadOptions const &Options = ReadOptions());
+	~ConfigWatcher();
+	ConfigWatcher(const ConfigWatcher&) = delete;
+	ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+	/** @brief Whether the most recent load succeeded */
+	bool Loaded() const;
+
+	/** @brief Calls `f` whenever `key` (of any type) changes */
+	void OnChange(std::string_view key, Callback f);
+	/** @brief Calls `f` for every change */
+	void OnAnyChange(Callback f);
+	/** @brief Publishes a snapshot of the Dict to `P` after every change (null to stop) */
+	void PublishTo(SnapshotPublisher* P);
+
+	/** @brief File descriptor that becomes readable when a file changes (-1 without inotify) */
+	int Fd() const;
+	/** @brief Waits up to `TimeoutMs` milliseconds (-1: forever) for changes and applies them */
+	std::size_t Poll(int TimeoutMs = -1);
+	/** @brief Checks every file for changes now and applies them */
+	std::size_t Reload();
+
+	private:
+	struct State;
+	std::unique_ptr<State> S;
+};
+
+/** @brief Outcome of SchemaBinding::Bind() */
+enum class BindResult : unsigned char {
+	Stored,    ///<The value was written to its field
+	Duplicate, ///<The field already holds a value from the configuration (the first one wins, as in a Dict)
+	Unknown,   ///<No field has this key
+	Mismatch   ///<The value cannot be converted to the type of its field
+};
+
+/** @brief A value read from a configuration, as offered to a SchemaBinding */
+struct BoundValue
+{
+	ValueType Type = ValueType::String;
+	int Int = 0;                ///<Value if `Type` is ValueType::Int
+	double Double = 0.0;        ///<Value if `Type` is ValueType::Double
+	std::string_view Text;      ///<Value as written (ValueType::String, Int and Double)
+	std::optional<bool> Bool;   ///<A string value of "true" or "false" (in any case)
+	Span<const int> Ints;       ///<Values if `Type` is ValueType::IntArray
+	Span<const double> Doubles; ///<Values if `Type` is ValueType::DoubleArray
+};
+
+/** @class SchemaBinding
+ * @brief Receives the values of a configuration as they are read, in place of a Dict
+ *
+ * ReadConfig() offers each value to Bind() in the order a Dict would
+ * receive it, so the first definition of a key wins and `include`,
+ * `enforce` and `BREAK` work as usual.  Schema::Binding implements it for
+ * a plain struct.
+ */
+class SchemaBinding
+{
+	public:
+	virtual ~SchemaBinding() = default;
+	/** @brief Stores `val` under `key` */
+	virtual BindResult Bind(std::string_view key, BoundValue const &val) = 0;
+	/** @brief Value stored under `key` as a string, if it holds one (for `enforce`) */
+	virtual std::optional<std::string> BoundString(std::string_view key) const = 0;
+};
+
+/** @brief Reads a configuration file into a SchemaBinding */
+bool ReadConfig(const char* filename, SchemaBinding &B, ReadOptions const &Options = ReadOptions());
+/** @overload */
+bool ReadConfig(std::istream &f_in, SchemaBinding &B, ReadOptions const &Options = ReadOptions());
+
+/** @brief Hash of a key in a Schema (64-bit FNV-1a), evaluated at compile time for constant schemas */
+constexpr std::uint64_t SchemaHash(std::string_view key)
+{
+	std::uint64_t h = 14695981039346656037ull;
+	for (char c : key) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+/** @brief Type in which a SchemaField keeps the default of a member of type `M`
+ *
+ * Strings and arrays keep theirs as views, so that a schema can be `constexpr`.
+ */
+template <class M>
+struct SchemaDefault {using type = M;};
+/** @cond */
+template <>
+struct SchemaDefault<std::string> {using type = std::string_view;};
+template <class E>
+struct SchemaDefault<std::vector<E>> {using type = Span<const E>;};
+/** @endcond */
+
+/** @brief A member of a struct read through a Schema (made by Field())
+ *
+ * Members may be `int`, `double`, `float`, `bool` (from "true" or
+ * "false"), `std::string` (from any single value, as written),
+ * `std::vector<int>` and `std::vector<double>` (from an array or a single
+ * number), or an enumeration.  An enumeration is read from the names in
+ * `Names` if there are any, and from an int otherwise.  An int is accepted
+ * where a double is expected, but not the other way around.
+ */
+template <class T, class M>
+struct SchemaField
+{
+	using Struct = T;
+	std::string_view Name;                     ///<Key of the member in the configuration
+	M T::* Member;                             ///<The member
+	typename SchemaDefault<M>::type Default;   ///<Value of the member if its key is absent
+	Span<const std::pair<std::string_view,M>> Names; ///<Names of the enumerators, matched exactly
+
+	/** @brief Sets the member of `Out` to the default */
+	void Reset(T &Out) const
+	{
+		if constexpr (std::is_same_v<M,std::string> || std::is_same_v<M,std::vector<int>> || std::is_same_v<M,std::vector<double>>)
+			(Out.*Member).assign(Default.begin(),Default.end());
+		else
+			Out.*Member = Default;
+	}
+
+	/** @brief Writes `V` to the member of `Out`, if it fits */
+	BindResult Assign(T &Out, BoundValue const &V) const
+	{
+		M &m = Out.*Member;
+		bool Scalar = (V.Type == ValueType::Int || V.Type == ValueType::Double || V.Type == ValueType::String);
+		if constexpr (std::is_same_v<M,bool>) {
+			if (!V.Bool)
+				return BindResult::Mismatch;
+			m = *V.Bool;
+		} else if constexpr (std::is_enum_v<M>) {
+			if (Names.empty()) {
+				if (V.Type != ValueType::Int)
+					return BindResult::Mismatch;
+				m = static_cast<M>(V.Int);
+			} else {
+				auto i = std::find_if(Names.begin(),Names.end(),[&](std::pair<std::string_view,M> const &N) {return N.first == V.Text;});
+				if (V.Type != ValueType::String || i == Names.end())
+					return BindResult::Mismatch;
+				m = i->second;
+			}
+		} else if constexpr (std::is_same_v<M,int>) {
+			if (V.Type != ValueType::Int)
+				return BindResult::Mismatch;
+			m = V.Int;
+		} else if constexpr (std::is_floating_point_v<M>) {
+			if (V.Type == ValueType::Double)
+				m = static_cast<M>(V.Double);
+			else if (V.Type == ValueType::Int)
+				m = static_cast<M>(V.Int);
+			else
+				return BindResult::Mismatch;
+		} else if constexpr (std::is_same_v<M,std::string>) {
+			if (!Scalar)
+				return BindResult::Mismatch;
+			m.assign(V.Text.data(),V.Text.length());
+		} else if constexpr (std::is_same_v<M,std::vector<int>>) {
+			if (V.Type == ValueType::IntArray)
+				m.assign(V.Ints.begin(),V.Ints.end());
+			else if (V.Type == ValueType::Int)
+				m.assign(1,V.Int);
+			else
+				return BindResult::Mismatch;
+		} else if constexpr (std::is_same_v<M,std::vector<double>>) {
+			if (V.Type == ValueType::DoubleArray)
+				m.assign(V.Doubles.begin(),V.Doubles.end());
+			else if (V.Type == ValueType::IntArray)
+				m.assign(V.Ints.begin(),V.Ints.end());
+			else if (V.Type == ValueType::Double)
+				m.assign(1,V.Double);
+			else if (V.Type == ValueType::Int)
+				m.assign(1,static_cast<double>(V.Int));
+			else
+				return BindResult::Mismatch;
+		} else {
+			static_assert(sizeof(M) == 0,"Schema members must be int, double, float, bool, std::string, std::vector<int>, std::vector<double> or an enumeration");
+		}
+		return BindResult::Stored;
+	}
+
+	/** @brief The member of `Out` as a string, if it is a string or a named enumerator */
+	std::optional<std::string> Text(T const &Out) const
+	{
+		if constexpr (std::is_same_v<M,std::string>) {
+			return Out.*Member;
+		} else if constexpr (std::is_enum_v<M>) {
+			for (std::pair<std::string_view,M> const &N : Names)
+				if (N.second == Out.*Member)
+					return std::string(N.first);
+		}
+		return std::nullopt;
+	}
+};
+
+/**
+ * @brief Describes member `Member` of a struct, read from key `Name`
+ * @param Name          Key in the configuration
+ * @param Member        Member of the struct
+ * @param Default       Value of the member if the key is absent
+ */
+template <class T, class M, class D>
+constexpr SchemaField<T,M> Field(std::string_view Name, M T::* Member, D const &Default)
+{
+	return SchemaField<T,M>{Name,Member,typename SchemaDefault<M>::type(Default),{}};
+}
+
+/** @overload (the default is a value-initialised `M`) */
+template <class T, class M>
+constexpr SchemaField<T,M> Field(std::string_view Name, M T::* Member)
+{
+	return SchemaField<T,M>{Name,Member,typename SchemaDefault<M>::type(),{}};
+}
+
+/** @overload (an enumeration read from the names in `Names`) */
+template <class T, class E, std::size_t N>
+constexpr SchemaField<T,E> Field(std::string_view Name, E T::* Member, E Default, std::pair<std::string_view,E> const (&Names)[N])
+{
+	static_assert(std::is_enum_v<E>,"Only enumerations are read from names");
+	return SchemaField<T,E>{Name,Member,Default,Span<const std::pair<std::string_view,E>>(Names,N)};
+}
+
+/** @class Schema
+ * @brief The members of a struct of type `T` to read from a configuration, and their keys
+ *
+ * A schema lists each member with Field() and is best declared `constexpr`,
+ * in which case the perfect hash of its keys is built at compile time:
+ * @code
+ * 	struct Settings {double CFL; Scheme Flux; int MaxIter;};
+ * 	constexpr std::pair<std::string_view,Scheme> SchemeNames[] = {{"HLLE",Scheme::HLLE},{"ROE",Scheme::ROE}};
+ * 	constexpr auto SettingsSchema = ParseLi::MakeSchema(
+ * 		ParseLi::Field("CFL_NUMBER",&Settings::CFL,0.5),
+ * 		ParseLi::Field("SCHEME",&Settings::Flux,Scheme::HLLE,SchemeNames),
+ * 		ParseLi::Field("MAXITER",&Settings::MaxIter,1000));
+ * 	Settings S;
+ * 	ParseLi::ReadConfig("Example.in",SettingsSchema,S);
+ * @endcode
+ * ReadConfig() then writes each value straight into its member as it is
+ * parsed, with no Dict in between.  A key is found by one hash, one probe
+ * of the perfect hash and one string comparison, and the member is written
+ * by code generated for its type.  Unknown keys and values that do not
+ * fit their member are all reported in the same read.
+*/
+template <class T, class... Fields>
+class Schema
+{
+	static_assert(sizeof...(Fields) > 0,"A schema needs at least one field");
+	static_assert((std::is_same_v<typename Fields::Struct,T> && ...),"All fields of a schema must belong to the same struct");
+	static constexpr std::size_t N = sizeof...(Fields);
+	std::tuple<Fields...> List;
+	std::array<std::uint32_t,PerfectBuckets(N)> Seeds {}; ///<Seeds of the perfect hash of the keys
+	std::array<std::string_view,N> Keys {};  ///<Key at each position of the perfect hash
+	std::array<std::size_t,N> Position {};   ///<Field at each position of the perfect hash
+
+	/** @brief Calls `f` with field `i` */
+	template <class F, std::size_t... I>
+	void Visit(std::size_t i, F &&f, std::index_sequence<I...>) const
+	{
+		((i == I ? (f(std::get<I>(List)),true) : false) || ...);
+	}
+	template <class F>
+	void Visit(std::size_t i, F &&f) const {Visit(i,std::forward<F>(f),std::index_sequence_for<Fields...>());}
+
+	public:
+	static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+	/** @brief Builds the schema from `f`, with a perfect hash of its keys
+	 * @throw std::logic_error if two fields have the same key (a compile error for a `constexpr` schema) */
+	constexpr explicit Schema(Fields... f) : List(f...)
+	{
+		std::string_view Names[N] = {f.Name...};
+		std::uint64_t Hashes[N] = {};
+		std::size_t Order[N] = {};
+		std::size_t Start[PerfectBuckets(N) + 1] = {};
+		bool Taken[N] = {};
+		for (std::size_t i = 0; i < N; i++)
+			Hashes[i] = SchemaHash(Names[i]);
+		if (!BuildPerfectHash(Hashes,N,Seeds.data(),Order,Start,Taken))
+			throw std::logic_error("ParseLi::Schema: duplicate key");
+		for (std::size_t i = 0; i < N; i++) {
+			std::size_t p = PerfectSlot(Hashes[i],Seeds.data(),N);
+			Keys[p] = Names[i];
+			Position[p] = i;
+		}
+	}
+
+	/** @brief Number of fields */
+	static constexpr std::size_t size() {return N;}
+
+	/** @brief Position of the field with key `key` (in the order given), or `npos` */
+	constexpr std::size_t Find(std::string_view key) const
+	{
+		std::size_t p = PerfectSlot(SchemaHash(key),Seeds.data(),N);
+		return (Keys[p] == key) ? Position[p] : npos;
+	}
+
+	/** @brief Sets every member of `Out` to its default */
+	void Reset(T &Out) const
+	{
+		std::apply([&](Fields const&... F) {(F.Reset(Out),...);},List);
+	}
+
+	/** @class Binding
+	 * @brief Writes the values of a read into a struct through the schema
+	 */
+	class Binding : public SchemaBinding
+	{
+		Schema const &S;
+		T &Out;
+		std::array<bool,N> Read {}; ///<Whether each field has been read
+		public:
+		/** @brief Binds `Out_` (whose members are left as they are until read) */
+		Binding(Schema const &S_, T &Out_) : S(S_), Out(Out_) {}
+
+		BindResult Bind(std::string_view key, BoundValue const &val) override
+		{
+			std::size_t i = S.Find(key);
+			if (i == npos)
+				return BindResult::Unknown;
+			if (Read[i])
+				return BindResult::Duplicate;
+			BindResult ret = BindResult::Mismatch;
+			S.Visit(i,[&](auto const &F) {ret = F.Assign(Out,val);});
+			Read[i] = (ret == BindResult::Stored);
+			return ret;
+		}
+
+		std::optional<std::string> BoundString(std::string_view key) const override
+		{
+			std::size_t i = S.Find(key);
+			std::optional<std::string> ret;
+			if (i != npos && Read[i])
+				S.Visit(i,[&](auto const &F) {ret = F.Text(Out);});
+			return ret;
+		}
+
+		/** @brief Whether the member of `key` was read (rather than left at its default) */
+		bool WasRead(std::string_view key) const
+		{
+			std::size_t i = S.Find(key);
+			return i != npos && Read[i];
+		}
+	};
+};
+
+/** @brief Makes a Schema of the struct the fields `f` belong to */
+template <class F, class... Fs>
+constexpr Schema<typename F::Struct,F,Fs...> MakeSchema(F f, Fs... fs)
+{
+	return Schema<typename F::Struct,F,Fs...>(f,fs...);
+}
+
+/**
+ * @brief Reads a configuration file straight into a struct
+ * @param filename      Name of the configuration file to read
+ * @param S             Members of the struct and their keys
+ * @param Out           Struct to read into; every member in `S` is first set to its default
+ * @param Options       How to read the file
+ * @return `True` on successful read, with every value matching the type of its member
+ */
+template <class T, class... Fields>
+bool ReadConfig(const char* filename, Schema<T,Fields...> const &S, T &Out, ReadOptions const &Options = ReadOptions())
+{
+	S.Reset(Out);
+	typename Schema<T,Fields...>::Binding B(S,Out);
+	return ReadConfig(filename,B,Options);
+}
+
+/** @overload */
+template <class T, class... Fields>
+bool ReadConfig(std::istream &f_in, Schema<T,Fields...> const &S, T &Out, ReadOptions const &Options = ReadOptions())
+{
+	S.Reset(Out);
+	typename Schema<T,Fields...>::Binding B(S,Out);
+	return ReadConfig(f_in,B,Options);
+}
+
 } //namespace Version
 } //namespace ParseLi
 
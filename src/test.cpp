@@ -1,6 +1,825 @@
 #include "parselib.cpp"
+#include <filesystem>
 #include <sstream>
 
+enum class Scheme {HLLE = 1, ROE = 2};
+
+//Solver settings read straight from the input file (see SettingsSchema)
+struct Settings
+{
+	double CFL_NUMBER;
+	Scheme SCHEME;
+	int NCELL;
+	bool FASTMODE;
+	std::string CASE;
+};
+
+constexpr std::pair<std::string_view,Scheme> SchemeNames[] = {{"HLLE",Scheme::HLLE},{"ROE",Scheme::ROE}};
+constexpr auto SettingsSchema = ParseLi::MakeSchema(
+	ParseLi::Field("CFL_NUMBER",&Settings::CFL_NUMBER,0.5),
+	ParseLi::Field("SCHEME",&Settings::SCHEME,Scheme::HLLE,SchemeNames),
+	ParseLi::Field("NCELL",&Settings::NCELL,100),
+	ParseLi::Field("FASTMODE",&Settings::FASTMODE,false),
+	ParseLi::Field("CASE",&Settings::CASE,"SHOCKTUBE"));
+
+static int Failures = 0;
+
+//Reports a failed check; main() returns non-zero if any check failed
+static void Check(bool Ok, const char* What)
+{
+	if (!Ok) {
+		printf("FAILED: %s\n",What);
+		Failures++;
+	}
+}
+
+//Writes `Text` to `Name`, replacing the file
+static void WriteFile(const char* Name, std::string const &Text)
+{
+	std::ofstream f_out(Name,std::ofstream::binary | std::ofstream::trunc);
+	f_out << Text;
+}
+
+//A final line without a newline is read by every reader
+static void TestFinalLine()
+{
+	WriteFile("test_final.in","A 1\nB 2.5");
+	ParseLi::ReadOptions Options[3];
+	Options[1].IncludeThreads = 2;
+	Options[2].ParseThreads = 2;
+	for (ParseLi::ReadOptions const &O : Options) {
+		ParseLi::Dict D;
+		Check(ParseLi::ReadConfig("test_final.in",&D,O),"final line: read file");
+		Check(D.GetOr("B",0.0) == 2.5,"final line: value from file");
+	}
+	ParseLi::Dict S;
+	std::istringstream f_in("A 1\nB 2.5");
+	Check(ParseLi::ReadConfig(f_in,&S) && S.GetOr("B",0.0) == 2.5,"final line: value from stream");
+	std::remove("test_final.in");
+}
+
+//A handle read while another thread keeps writing sees each value whole, in order
+static void TestHandleUnderWrites()
+{
+	ParseLi::Dict D;
+	D.add("X",0.0);
+	std::atomic<bool> Done{false};
+	std::thread Writer([&]{
+		for (int i = 1; i <= 20000; i++) {
+			D.set("X",static_cast<double>(i));
+			std::string Other = "K" + std::to_string(i % 300);
+			D.set(Other,i);
+			if (i % 7 == 0)
+				D.erase(Other);
+		}
+		Done = true;
+	});
+	ParseLi::Dict::Handle<double> X = D.GetHandle<double>("X");
+	double Last = 0.0;
+	bool Ordered = true;
+	while (!Done) {
+		double v = X.Get();
+		Ordered = Ordered && v >= Last && v == static_cast<int>(v);
+		Last = v;
+	}
+	Writer.join();
+	Check(Ordered && X.Get() == 20000.0,"handle: values read during writes");
+}
+
+//Slot chunks replaced while a handle exists are freed once no read is in progress
+static void TestHandleReclaim()
+{
+	ParseLi::Dict D;
+	for (int i = 0; i < 1000; i++)
+		D.add("K" + std::to_string(i),i);
+	ParseLi::Dict::Handle<int> K = D.GetHandle<int>("K0");
+	Check(K.Get() == 0,"handle: first read");
+	std::size_t Before = D.Memory().SlotBytes;
+	for (int r = 1; r <= 200; r++) {
+		std::shared_ptr<const ParseLi::FrozenDict> Snapshot = D.Freeze(); //Shares every chunk, as ConfigWatcher::PublishTo does
+		for (int i = 0; i < 1000; i += 50)
+			D.set("K" + std::to_string(i),i + r);
+		Check(K.Get() == r,"handle: read after a reload");
+	}
+	Check(D.Memory().SlotBytes == Before,"handle: replaced slot chunks are freed");
+}
+
+//Every token scanner finds the same word ends and blank runs
+static void TestTokenScanners()
+{
+	struct Scan {ParseLi::ScanFunction FindDelimiter, SkipBlanks; bool Supported;};
+	std::vector<Scan> Scans;
+#ifdef PARSELI_HAVE_X86_SIMD
+	__builtin_cpu_init();
+	Scans.push_back({ParseLi::FindDelimiterSSE2,ParseLi::SkipBlanksSSE2,static_cast<bool>(__builtin_cpu_supports("sse2"))});
+	Scans.push_back({ParseLi::FindDelimiterAVX2,ParseLi::SkipBlanksAVX2,static_cast<bool>(__builtin_cpu_supports("avx2"))});
+#endif
+	//Runs ending just before, at and after the 16- and 32-byte block edges,
+	//starting at every alignment within a block
+	const char Delimiters[] = {' ','\t','#','\n','\0'};
+	bool WordsAgree = true, BlanksAgree = true;
+	for (std::size_t Start = 0; Start < 33; Start++)
+		for (std::size_t Len = 0; Len <= 70; Len++)
+			for (std::size_t d = 0; d <= sizeof(Delimiters); d++) {
+				//A word of `Len` bytes, then a delimiter (or nothing) and more text
+				std::string Word(Start,'x');
+				Word.append(Len,'a');
+				if (d < sizeof(Delimiters))
+					Word.push_back(Delimiters[d]);
+				Word.append(40,'b');
+				//A blank run of `Len` bytes mixing spaces and tabs, then `Delimiters[d]` or a word
+				std::string Blank(Start,'x');
+				for (std::size_t i = 0; i < Len; i++)
+					Blank.push_back((i % 3) ? ' ' : '\t');
+				Blank.push_back(d < sizeof(Delimiters) && Delimiters[d] != ' ' && Delimiters[d] != '\t' ? Delimiters[d] : 'y');
+				Blank.append(40,' ');
+				//Scan to the end of the buffer and to a limit inside it
+				for (std::size_t n : {Word.size() - Start, Len, Len + 1}) {
+					std::size_t Expect = ParseLi::FindDelimiterScalar(Word.data() + Start,n);
+					for (Scan const &S : Scans)
+						if (S.Supported && S.FindDelimiter(Word.data() + Start,n) != Expect)
+							WordsAgree = false;
+				}
+				for (std::size_t n : {Blank.size() - Start, Len, Len + 1}) {
+					std::size_t Expect = ParseLi::SkipBlanksScalar(Blank.data() + Start,n);
+					for (Scan const &S : Scans)
+						if (S.Supported && S.SkipBlanks(Blank.data() + Start,n) != Expect)
+							BlanksAgree = false;
+				}
+			}
+	Check(WordsAgree,"scanner: SIMD FindDelimiter matches the scalar one");
+	Check(BlanksAgree,"scanner: SIMD SkipBlanks matches the scalar one");
+	Check(ParseLi::FindDelimiterScalar("abc#def",7) == 3 && ParseLi::SkipBlanksScalar(" \t x",4) == 3,"scanner: scalar scans");
+}
+
+//An include cycle is reported with its chain, and a file included under two
+//names is parsed once, both sequentially and by the include prefetcher
+static void TestIncludeGraph()
+{
+	WriteFile("test_cyc_a.in","A 1\ninclude test_cyc_b.in\n");
+	WriteFile("test_cyc_b.in","B 2\ninclude test_cyc_c.in\n");
+	WriteFile("test_cyc_c.in","C 3\ninclude ./test_cyc_a.in\n");
+	WriteFile("test_dia.in","T 1\ninclude test_dia_l.in\ninclude test_dia_r.in\n");
+	WriteFile("test_dia_l.in","L 2\ninclude test_dia_d.in\n");
+	WriteFile("test_dia_r.in","R 3\ninclude ./test_dia_d.in\n");
+	WriteFile("test_dia_d.in","D 4\nE 5\nF 6\n");
+	for (unsigned Threads : {0u,4u}) {
+		ParseLi::BufferedDiagnostics Log;
+		ParseLi::ReadOptions Options;
+		Options.IncludeThreads = Threads;
+		Options.Diagnostics = &Log;
+		ParseLi::Dict D;
+		ParseLi::ReadConfig("test_cyc_a.in",&D,Options);
+		std::vector<ParseLi::Diagnostic> Records = Log.Take();
+		Check(Records.size() == 1 && Records[0].Level == ParseLi::Severity::Error &&
+			Records[0].Message.find("test_cyc_a.in -> test_cyc_b.in -> test_cyc_c.in -> ./test_cyc_a.in") != std::string::npos,
+			Threads ? "include cycle: chain reported (prefetched)" : "include cycle: chain reported");
+		Check(D.GetOr("A",0) == 1 && D.GetOr("B",0) == 2 && D.GetOr("C",0) == 3,
+			Threads ? "include cycle: values outside the cycle kept (prefetched)" : "include cycle: values outside the cycle kept");
+
+		ParseLi::EnableStats();
+		ParseLi::ResetStats();
+		ParseLi::Dict E;
+		ParseLi::ReadConfig("test_dia.in",&E,Options);
+		std::uint64_t Lines = 0;
+		for (ParseLi::FileStats const &F : ParseLi::GetStats().Files)
+			if (F.Filename.find("test_dia_d.in") != std::string::npos)
+				Lines += F.Lines;
+		ParseLi::EnableStats(false);
+		Check(Log.Take().empty() && E.GetOr("T",0) == 1 && E.GetOr("L",0) == 2 && E.GetOr("R",0) == 3 && E.GetOr("F",0) == 6,
+			Threads ? "include diamond: every value read (prefetched)" : "include diamond: every value read");
+		Check(Lines == 3,Threads ? "include diamond: shared file parsed once (prefetched)" : "include diamond: shared file parsed once");
+	}
+	for (const char* Name : {"test_cyc_a.in","test_cyc_b.in","test_cyc_c.in","test_dia.in","test_dia_l.in","test_dia_r.in","test_dia_d.in"})
+		std::remove(Name);
+}
+
+//A no-op add of an existing key must not invalidate pinned handles
+static void TestAddExisting()
+{
+	ParseLi::Dict D;
+	D.add("K",1);
+	ParseLi::Dict::Handle<int> K = D.GetHandle<int>("K");
+	Check(K.Get() == 1,"add: first read");
+	ParseLi::EnableStats();
+	ParseLi::ResetStats();
+	Check(!D.add("K",2) && !D.add("K",3),"add: existing key is kept");
+	D.try_set("K",4);
+	Check(K.Get() == 1,"add: read after no-op adds");
+	ParseLi::Stats S = ParseLi::GetStats();
+	Check(S.Total(ParseLi::LookupKind::Handle).Hits == 0,"add: no-op adds leave the handle pinned");
+	Check(D.add("L",5) && D.GetInt("L") == 5,"add: new key is added");
+	Check(K.Get() == 1,"add: read after a real add");
+	ParseLi::EnableStats(false);
+}
+
+//Threads writing and reading a ConcurrentDict see their own values and whole values of others
+static void TestConcurrentDict()
+{
+	ParseLi::ConcurrentDict C(8);
+	const int Threads = 4, Keys = 2000;
+	std::atomic<int> Mismatches{0};
+	std::vector<std::thread> Workers;
+	for (int t = 0; t < Threads; t++)
+		Workers.emplace_back([&,t]{
+			for (int i = 0; i < Keys; i++) {
+				std::string Own = "T" + std::to_string(t) + "_" + std::to_string(i);
+				C.set(Own,i);
+				C.set("SHARED",static_cast<double>(t));
+				if (C.GetInt(Own) != i || !C.add(Own + "_S",Own) || C.add(Own,-1))
+					Mismatches++;
+				double v = C.GetDouble("SHARED");
+				if (v != static_cast<int>(v) || v < 0 || v >= Threads)
+					Mismatches++;
+				if (i % 5 == 0 && !C.erase(Own + "_S"))
+					Mismatches++;
+			}
+		});
+	for (std::thread &W : Workers)
+		W.join();
+	Check(Mismatches == 0,"concurrent dict: values read back while other threads write");
+	Check(C.GetOr("T3_1999",0) == 1999 && C.GetOr("T0_7_S","") == "T0_7" && !C.CheckString("T0_5_S"),"concurrent dict: every thread's values kept");
+	std::shared_ptr<const ParseLi::FrozenDict> Snapshot = C.Freeze();
+	Check(Snapshot->Memory().Entries == C.Memory().Entries && Snapshot->GetInt("T2_42") == 42,"concurrent dict: frozen snapshot holds every value");
+	C.set("T2_42",-42);
+	Check(Snapshot->GetInt("T2_42") == 42 && C.GetInt("T2_42") == -42,"concurrent dict: snapshot unchanged by later writes");
+
+	ParseLi::Dict D;
+	D.add("A",1);
+	const double Xs[] = {1.0,2.0};
+	D.add("XS",ParseLi::Span<const double>(Xs));
+	ParseLi::ConcurrentDict FromDict(D);
+	Check(FromDict.GetInt("A") == 1 && FromDict.GetDoubleArray("XS").size() == 2,"concurrent dict: built from a Dict");
+}
+
+//Dictionaries assigned to each other from two threads, and to themselves, do not deadlock
+static void TestDictAssignment()
+{
+	ParseLi::Dict A, B;
+	A.add("K",1);
+	B.add("K",2);
+	std::thread Other([&]{
+		for (int i = 0; i < 2000; i++)
+			B = A;
+	});
+	for (int i = 0; i < 2000; i++)
+		A = B;
+	Other.join();
+	int a = A.GetOr("K",0), b = B.GetOr("K",0);
+	Check((a == 1 || a == 2) && (b == 1 || b == 2),"assignment: from two threads");
+	ParseLi::Dict &Same = A;
+	int Before = A.GetOr("K",0);
+	A = Same;
+	Check(A.GetOr("K",0) == Before && Before != 0,"assignment: to itself");
+}
+
+//Lines of several numbers are read as arrays, which erase() removes like any value
+static void TestArrays()
+{
+	WriteFile("test_arrays.in","XS 0.0 0.1 0.2\nCELLS 10 20 30\nEXP 1 2e3\nWORDS a b c\nN 5\n");
+	ParseLi::Dict D;
+	ParseLi::ReadConfig("test_arrays.in",&D);
+	std::remove("test_arrays.in");
+	ParseLi::Span<const double> XS = D.GetDoubleArray("XS");
+	Check(XS.size() == 3 && XS[0] == 0.0 && XS[1] == 0.1 && XS[2] == 0.2,"arrays: doubles read");
+	ParseLi::Span<const int> Cells = D.GetIntArray("CELLS");
+	Check(Cells.size() == 3 && Cells[0] == 10 && Cells[2] == 30,"arrays: ints read");
+	Check(D.CheckDoubleArray("EXP") && !D.CheckIntArray("EXP") && D.GetDoubleArray("EXP")[1] == 2000.0,"arrays: an exponent makes a double array");
+	Check(D.GetOr("WORDS","") == "a" && !D.CheckIntArray("WORDS") && !D.CheckDoubleArray("WORDS"),"arrays: words keep the first value");
+	Check(D.GetOr("N",0) == 5 && !D.CheckIntArray("N"),"arrays: a single number is not an array");
+
+	Check(D.erase("CELLS") && !D.CheckIntArray("CELLS") && !D.TryGetIntArray("CELLS"),"arrays: erase(key) removes an int array");
+	Check(D.erase("XS",ParseLi::ValueType::DoubleArray) && !D.CheckDoubleArray("XS"),"arrays: erase(key, type) removes a double array");
+	Check(!D.erase("CELLS") && D.CheckDoubleArray("EXP"),"arrays: erase leaves other arrays");
+	const double Again[] = {4.0,5.0};
+	D.set("XS",ParseLi::Span<const double>(Again));
+	Check(D.GetDoubleArray("XS").size() == 2 && D.GetDoubleArray("XS")[1] == 5.0,"arrays: set after erase");
+}
+
+//`binary` maps files of native values as arrays, and rejects files of partial values
+static void TestBinaryArrays()
+{
+	const double Coeffs[] = {1.5,-2.0,3.25,1e-9};
+	const int Ids[] = {7,-8,9};
+	WriteFile("test_coeffs.bin",std::string(reinterpret_cast<const char*>(Coeffs),sizeof(Coeffs)));
+	WriteFile("test_ids.bin",std::string(reinterpret_cast<const char*>(Ids),sizeof(Ids)));
+	WriteFile("test_partial.bin",std::string(sizeof(double) + 3,'x'));
+	WriteFile("test_binary.in","binary COEFFS double test_coeffs.bin\nbinary IDS int test_ids.bin\n");
+	WriteFile("test_binary_partial.in","A 1\nbinary PARTIAL double test_partial.bin\nB 2\n");
+	WriteFile("test_binary_missing.in","binary MISSING int test_missing.bin\n");
+
+	ParseLi::BufferedDiagnostics Log;
+	ParseLi::ReadOptions Options;
+	Options.Diagnostics = &Log;
+	ParseLi::Dict D;
+	ParseLi::ReadConfig("test_binary.in",&D,Options);
+	ParseLi::Span<const double> C = D.GetDoubleArray("COEFFS");
+	ParseLi::Span<const int> I = D.GetIntArray("IDS");
+	Check(Log.Take().empty(),"binary: mapped without messages");
+	Check(std::equal(C.begin(),C.end(),std::begin(Coeffs),std::end(Coeffs)),"binary: double values round-trip");
+	Check(std::equal(I.begin(),I.end(),std::begin(Ids),std::end(Ids)),"binary: int values round-trip");
+	Check(D.Memory().MappedBytes >= sizeof(Coeffs) + sizeof(Ids),"binary: values mapped, not copied");
+	ParseLi::Dict Copy(D);
+	Check(Copy.GetDoubleArray("COEFFS").data() == C.data(),"binary: copies share the mapping");
+	Check(D.erase("COEFFS") && !D.CheckDoubleArray("COEFFS") && Copy.GetDoubleArray("COEFFS")[2] == 3.25,"binary: erase keeps the copy's mapping");
+
+	//A file that cannot be mapped fails the read
+	ParseLi::Dict Bad;
+	bool Read = ParseLi::ReadConfig("test_binary_partial.in",&Bad,Options);
+	std::vector<ParseLi::Diagnostic> Records = Log.Take();
+	Check(!Read && Records.size() == 1 && Records[0].Level == ParseLi::Severity::Error && Records[0].Key == "PARTIAL" &&
+		Records[0].Message.find("whole number of double values") != std::string::npos,"binary: partial value reported");
+	Check(!Bad.CheckDoubleArray("PARTIAL") && Bad.GetOr("A",0) == 1,"binary: partial file stores nothing");
+	Read = ParseLi::ReadConfig("test_binary_missing.in",&Bad,Options);
+	Records = Log.Take();
+	Check(!Read && Records.size() == 1 && Records[0].Key == "MISSING" && !Bad.CheckIntArray("MISSING"),"binary: missing file reported");
+	ParseLi::MappedArray M;
+	Check(!M.Open("test_partial.bin",ParseLi::ValueType::DoubleArray) && M.Open("test_ids.bin",ParseLi::ValueType::IntArray) && M.size() == 3,"binary: MappedArray::Open checks the size");
+
+	for (const char* Name : {"test_coeffs.bin","test_ids.bin","test_partial.bin","test_binary.in","test_binary_partial.in","test_binary_missing.in"})
+		std::remove(Name);
+}
+
+//Whether two views hold the same value (arrays are compared element by element)
+static bool SameView(ParseLi::ValueTable::ValueView const &A, ParseLi::ValueTable::ValueView const &B)
+{
+	if (A.index() != B.index())
+		return false;
+	return std::visit([&](auto const &a) {
+		using T = std::decay_t<decltype(a)>;
+		T const &b = std::get<T>(B);
+		if constexpr (std::is_same_v<T,ParseLi::Span<const int>> || std::is_same_v<T,ParseLi::Span<const double>>)
+			return std::equal(a.begin(),a.end(),b.begin(),b.end());
+		else
+			return a == b;
+	},A);
+}
+
+//Prefix and range queries view the values in key order, typed or not
+static void TestPrefixRange()
+{
+	ParseLi::Dict D;
+	D.add("BC_LEFT_P",1.5);
+	D.add("BC_LEFT_N",2);
+	D.add("BC_LEFT_KIND","wall");
+	D.add("BC_RIGHT_P",3.5);
+	const int Ints[] = {1,2,3};
+	D.add("BC_LEFT_CELLS",ParseLi::Span<const int>(Ints));
+	D.add("BC_LEFT_N",7.0); //Same key, another type
+
+	std::vector<ParseLi::DictEntry> All = D.Prefix("BC_LEFT_");
+	std::vector<std::string_view> Keys;
+	for (ParseLi::DictEntry const &E : All)
+		Keys.push_back(E.Key);
+	Check(Keys == std::vector<std::string_view>{"BC_LEFT_CELLS","BC_LEFT_KIND","BC_LEFT_N","BC_LEFT_N","BC_LEFT_P"},"prefix: keys in order");
+	Check(All.size() == 5 && All[1].Type == ParseLi::ValueType::String && std::get<std::string_view>(All[1].Value) == "wall","prefix: string viewed");
+	Check(All.size() == 5 && SameView(All[0].Value,ParseLi::Span<const int>(Ints)),"prefix: array viewed");
+
+	auto Doubles = D.Prefix<double>("BC_");
+	Check(Doubles.size() == 3 && Doubles[0].first == "BC_LEFT_N" && Doubles[0].second == 7.0 && Doubles[2].second == 3.5,"prefix: typed doubles");
+	auto Ints2 = D.Prefix<int>("BC_LEFT_");
+	Check(Ints2.size() == 1 && Ints2[0].first == "BC_LEFT_N" && Ints2[0].second == 2,"prefix: typed ints");
+	auto Strings = D.Range<std::string_view>("BC_LEFT_","BC_RIGHT_");
+	Check(Strings.size() == 1 && Strings[0].second == "wall","range: typed strings");
+	auto Arrays = D.Range<ParseLi::Span<const int>>("BC_","C");
+	Check(Arrays.size() == 1 && Arrays[0].second.size() == 3 && Arrays[0].second[2] == 3,"range: typed arrays");
+	//The view points into the dictionary rather than at a copy
+	ParseLi::Span<const int> Stored = D.GetIntArray("BC_LEFT_CELLS");
+	Check(Arrays.size() == 1 && Arrays[0].second.data() == Stored.data(),"range: arrays are not copied");
+	Check(D.Range("BC_LEFT_P","BC_RIGHT_P").size() == 1 && D.Range<double>("C","D").empty(),"range: bounds");
+}
+
+//Whether two dictionaries hold the same keys, types and values
+static bool SameValues(ParseLi::Dict const &A, ParseLi::Dict const &B)
+{
+	std::vector<ParseLi::DictEntry> EA = A.Prefix(""), EB = B.Prefix("");
+	if (EA.size() != EB.size())
+		return false;
+	for (std::size_t i = 0; i < EA.size(); i++)
+		if (EA[i].Key != EB[i].Key || EA[i].Type != EB[i].Type || !SameView(EA[i].Value,EB[i].Value))
+			return false;
+	return true;
+}
+
+//Reads `Name` through its cache image into `D`, returning whether the image was used
+static bool CachedRead(const char* Name, ParseLi::Dict &D)
+{
+	ParseLi::BufferedDiagnostics Log;
+	ParseLi::ReadOptions Options;
+	Options.Cache = true;
+	Options.Debug = true;
+	Options.Diagnostics = &Log;
+	ParseLi::ReadConfig(Name,&D,Options);
+	for (ParseLi::Diagnostic const &R : Log.Take())
+		if (R.Message.find("from cache") != std::string::npos)
+			return true;
+	return false;
+}
+
+//A cached read matches a fresh one, and a changed file invalidates the image
+static void TestCache()
+{
+	namespace fs = std::filesystem;
+	auto Later = [](const char* Name) {fs::last_write_time(Name,fs::last_write_time(Name) + std::chrono::seconds(5));};
+	auto MatchesFresh = [](ParseLi::Dict const &D) {
+		ParseLi::Dict F;
+		ParseLi::ReadConfig("test_cache.in",&F);
+		return SameValues(D,F);
+	};
+	std::remove("test_cache.in.plcache");
+	std::remove("test_cache_new.in");
+	WriteFile("test_cache.in","A 1\ninclude test_cache_inc.in\ninclude test_cache_new.in\n");
+	WriteFile("test_cache_inc.in","B 2.5\n");
+
+	ParseLi::Dict D1, D2, D3, D4, D5, D6, D7;
+	Check(!CachedRead("test_cache.in",D1),"cache: first read parses");
+	Check(CachedRead("test_cache.in",D2) && MatchesFresh(D2),"cache: unchanged files hit");
+	Later("test_cache_inc.in");
+	Check(CachedRead("test_cache.in",D3) && MatchesFresh(D3),"cache: touched file with the same contents hits");
+	WriteFile("test_cache_inc.in","B 12.5\n");
+	Check(!CachedRead("test_cache.in",D4) && D4.GetOr("B",0.0) == 12.5,"cache: size change is a miss");
+	WriteFile("test_cache_inc.in","B 17.5\n");
+	Later("test_cache_inc.in");
+	Check(!CachedRead("test_cache.in",D5) && D5.GetOr("B",0.0) == 17.5,"cache: edited include is a miss");
+	WriteFile("test_cache_new.in","C 3\n");
+	Check(!CachedRead("test_cache.in",D6) && D6.GetOr("C",0) == 3 && MatchesFresh(D6),"cache: created include is a miss");
+
+	fs::path Cwd = fs::current_path();
+	fs::create_directory("test_cache_dir");
+	fs::current_path("test_cache_dir");
+	Check(!CachedRead("../test_cache.in",D7),"cache: other working directory is a miss");
+	fs::current_path(Cwd);
+	fs::remove_all("test_cache_dir");
+	for (const char* Name : {"test_cache.in","test_cache_inc.in","test_cache_new.in","test_cache.in.plcache"})
+		std::remove(Name);
+}
+
+//A deck of about `Bytes` bytes with duplicate keys, and directives wherever a chunk boundary may fall
+static std::string ChunkedDeck(std::size_t Bytes)
+{
+	std::string Text;
+	std::size_t Next = 0;
+	for (int i = 0; Text.size() < Bytes; i++) {
+		if (Text.size() >= Next) {
+			Text += "WARNING near byte " + std::to_string(Text.size()) + "\n";
+			Text += "include test_chunk_inc.in\n";
+			Text += "enforce MODE fast\n";
+			Next += Bytes / 32;
+		}
+		if (i % 7 == 0)
+			Text += "# comment " + std::to_string(i) + "\n";
+		std::string Key = "K" + std::to_string(i % 5000);
+		switch (i % 3) {
+			case 0: Text += Key + " " + std::to_string(i) + "\n"; break;
+			case 1: Text += Key + " " + std::to_string(i) + ".5\n"; break;
+			default: Text += Key + " s" + std::to_string(i) + "\n"; break;
+		}
+	}
+	return Text;
+}
+
+//Inserts `Line` at the start of the line holding byte `At`
+static std::string InsertLine(std::string Text, std::size_t At, std::string const &Line)
+{
+	return Text.insert(Text.rfind('\n',At) + 1,Line + "\n");
+}
+
+//Whether two reads reported the same messages, at the same lines
+static bool SameDiagnostics(std::vector<ParseLi::Diagnostic> const &A, std::vector<ParseLi::Diagnostic> const &B)
+{
+	if (A.size() != B.size())
+		return false;
+	for (std::size_t i = 0; i < A.size(); i++)
+		if (A[i].Level != B[i].Level || A[i].File != B[i].File || A[i].Line != B[i].Line || A[i].Key != B[i].Key || A[i].Message != B[i].Message)
+			return false;
+	return true;
+}
+
+//Parsing in chunks on several threads gives exactly the result of a serial read
+static void TestParseChunked()
+{
+	WriteFile("test_chunk_inc.in","INC 1\nMODE fast\n");
+	std::string Base = ChunkedDeck(2 << 20); //Well over MinChunkSize per chunk
+	std::pair<const char*,std::string> Decks[] = {
+		{"chunked: plain deck",Base + "TAIL 1"},
+		{"chunked: BREAK",InsertLine(Base,Base.size() * 5 / 8,"BREAK")},
+		{"chunked: failed enforce",InsertLine(Base,Base.size() * 3 / 4,"enforce MODE slow")}};
+	for (auto const &[What, Text] : Decks) {
+		WriteFile("test_chunk.in",Text);
+		//Reads the deck from the file, or from a stream, with `Threads` parse threads
+		auto Read = [&](ParseLi::Dict &D, std::vector<ParseLi::Diagnostic> &Records, unsigned Threads, unsigned IncludeThreads, bool Stream) {
+			ParseLi::BufferedDiagnostics Log(ParseLi::Severity::Warning);
+			ParseLi::ReadOptions Options;
+			Options.ParseThreads = Threads;
+			Options.IncludeThreads = IncludeThreads;
+			Options.Diagnostics = &Log;
+			bool Ok;
+			if (Stream) {
+				std::istringstream f_in(Text);
+				Ok = ParseLi::ReadConfig(f_in,&D,Options);
+			} else {
+				Ok = ParseLi::ReadConfig("test_chunk.in",&D,Options);
+			}
+			Records = Log.Take();
+			return Ok;
+		};
+		ParseLi::Dict Serial, SerialStream;
+		std::vector<ParseLi::Diagnostic> SerialLog, SerialStreamLog;
+		bool SerialOk = Read(Serial,SerialLog,0,0,false);
+		bool SerialStreamOk = Read(SerialStream,SerialStreamLog,0,0,true);
+		bool Lines = SerialLog.size() > 1;
+		for (ParseLi::Diagnostic const &R : SerialLog)
+			Lines = Lines && (R.Level != ParseLi::Severity::Warning || R.Line > 0);
+		Check(Lines,(std::string(What) + ": warnings carry their lines").c_str());
+
+		for (unsigned IncludeThreads : {0u,2u}) {
+			ParseLi::Dict Chunked, ChunkedStream;
+			std::vector<ParseLi::Diagnostic> ChunkedLog, ChunkedStreamLog;
+			bool ChunkedOk = Read(Chunked,ChunkedLog,3,IncludeThreads,false);
+			Check(ChunkedOk == SerialOk && SameValues(Chunked,Serial) && SameDiagnostics(ChunkedLog,SerialLog),(std::string(What) + ": file").c_str());
+			bool ChunkedStreamOk = Read(ChunkedStream,ChunkedStreamLog,3,IncludeThreads,true);
+			Check(ChunkedStreamOk == SerialStreamOk && SameValues(ChunkedStream,SerialStream) && SameDiagnostics(ChunkedStreamLog,SerialStreamLog),(std::string(What) + ": stream").c_str());
+		}
+	}
+	std::remove("test_chunk.in");
+	std::remove("test_chunk_inc.in");
+}
+
+//Finds the change to `Key` among those reported
+static ParseLi::ConfigChange const* FindChange(std::vector<ParseLi::ConfigChange> const &Changes, const char* Key)
+{
+	for (ParseLi::ConfigChange const &C : Changes)
+		if (C.Key == Key)
+			return &C;
+	return nullptr;
+}
+
+//The watcher applies edits and reports each difference once
+static void TestWatcher()
+{
+	using Kind = ParseLi::ConfigChange::Kind;
+	WriteFile("test_watch.in","A 1\nS hello\ninclude test_watch_inc.in\n");
+	WriteFile("test_watch_inc.in","C 3\n");
+	ParseLi::Dict D;
+	ParseLi::ConfigWatcher W("test_watch.in",&D);
+	Check(W.Loaded() && D.GetOr("A",0) == 1 && D.GetOr("C",0) == 3,"watcher: initial load");
+	D.add("USER",7);
+	std::vector<ParseLi::ConfigChange> Seen;
+	int ChangesToA = 0;
+	W.OnAnyChange([&](ParseLi::ConfigChange const &C) {Seen.push_back(C);});
+	W.OnChange("A",[&](ParseLi::ConfigChange const &) {ChangesToA++;});
+
+	//A modified, S removed, T added
+	WriteFile("test_watch.in","A 2\nT fresh\ninclude test_watch_inc.in\n");
+	Check(W.Poll(1000) == 3 && Seen.size() == 3,"watcher: edit reports three changes");
+	ParseLi::ConfigChange const* A = FindChange(Seen,"A");
+	Check(A && A->Change == Kind::Modified && A->Old == ParseLi::ValueTable::Value(1) && A->New == ParseLi::ValueTable::Value(2),"watcher: modified value");
+	ParseLi::ConfigChange const* S = FindChange(Seen,"S");
+	Check(S && S->Change == Kind::Removed && S->Old == ParseLi::ValueTable::Value(std::string("hello")),"watcher: removed value");
+	ParseLi::ConfigChange const* T = FindChange(Seen,"T");
+	Check(T && T->Change == Kind::Added && T->New == ParseLi::ValueTable::Value(std::string("fresh")),"watcher: added value");
+	Check(ChangesToA == 1,"watcher: key callback");
+	Check(D.GetOr("A",0) == 2 && !D.CheckString("S") && D.GetOr("T","") == "fresh","watcher: dictionary updated");
+	Check(D.GetOr("USER",0) == 7,"watcher: other keys left alone");
+
+	//An include replaced by a rename, as editors save
+	Seen.clear();
+	WriteFile("test_watch_inc.tmp","C 42\n");
+	std::rename("test_watch_inc.tmp","test_watch_inc.in");
+	Check(W.Poll(1000) == 1 && Seen.size() == 1 && D.GetOr("C",0) == 42,"watcher: include renamed over");
+	Check(ChangesToA == 1,"watcher: key callback only for its key");
+
+	Seen.clear();
+	Check(W.Reload() == 0 && Seen.empty(),"watcher: nothing changed");
+	std::remove("test_watch.in");
+	std::remove("test_watch_inc.in");
+}
+
+//Reloads that keep replacing a string do not grow the arena without bound
+static void TestWatcherArena()
+{
+	WriteFile("test_arena.in","TITLE x\nN 0\nM 1\n");
+	ParseLi::Dict D;
+	ParseLi::ConfigWatcher W("test_arena.in",&D);
+	//A handle keeps reading while compaction replaces the slot chunks
+	std::atomic<bool> Done{false};
+	bool Ordered = true;
+	std::thread Reader([&]{
+		ParseLi::Dict::Handle<int> N = D.GetHandle<int>("N");
+		int Last = 0;
+		while (!Done) {
+			int v = N.Get();
+			Ordered = Ordered && v >= Last && v < 400;
+			Last = v;
+		}
+	});
+	for (int r = 0; r < 400; r++) {
+		//A different length each time, so the change is seen without inotify too
+		std::string Title(1000 + r,static_cast<char>('a' + r % 26));
+		WriteFile("test_arena.in","TITLE " + Title + "\nN " + std::to_string(r) + "\nM 1\n");
+		W.Reload();
+		Check(D.GetOr("TITLE","") == Title,"watcher arena: reload applied");
+	}
+	Done = true;
+	Reader.join();
+	Check(Ordered,"watcher arena: handle read during compaction");
+	Check(D.GetOr("M",0) == 1,"watcher arena: unchanged value kept");
+	Check(D.Memory().ArenaUsed < 256 * 1024,"watcher arena: stale values are compacted");
+	std::remove("test_arena.in");
+}
+
+//By default warnings and errors are printed, and debug output only when asked for
+static void TestDefaultDiagnostics()
+{
+	Check(std::dynamic_pointer_cast<ParseLi::StreamDiagnostics>(ParseLi::GetDiagnostics()) != nullptr,"diagnostics: default sink prints");
+	//Everything a read reports, as the default sink would be offered it
+	auto Log = std::make_shared<ParseLi::BufferedDiagnostics>();
+	std::shared_ptr<ParseLi::DiagnosticSink> Default = ParseLi::SetDiagnostics(Log);
+	WriteFile("test_diag.in","A 1\nWARNING careful\n");
+	ParseLi::Dict D;
+	ParseLi::ReadConfig("test_diag.in",&D);
+	std::vector<ParseLi::Diagnostic> Records = Log->Take();
+	Check(Records.size() == 1 && Records[0].Level == ParseLi::Severity::Warning,"diagnostics: only warnings without Debug");
+	ParseLi::ReadConfig("test_diag.in",&D,true);
+	Records = Log->Take();
+	Check(Records.size() > 1 && Records[0].Level == ParseLi::Severity::Debug,"diagnostics: debug output with Debug");
+	bool Threw = false;
+	try {
+		D.GetInt("TEST_MISSING");
+	} catch (std::out_of_range const&) {
+		Threw = true;
+	}
+	Records = Log->Take();
+	Check(Threw && Records.size() == 1 && Records[0].Key == "TEST_MISSING" && Records[0].Level == ParseLi::Severity::Error,"diagnostics: failed lookup reported");
+	ParseLi::SetDiagnostics(Default);
+	std::remove("test_diag.in");
+
+	//A full buffer turns records down before they are formatted
+	ParseLi::BufferedDiagnostics Small(ParseLi::Severity::Debug,2);
+	ParseLi::ReadOptions Options;
+	Options.Debug = true;
+	Options.Diagnostics = &Small;
+	WriteFile("test_diag.in","A 1\nB 2\nC 3\nD 4\n");
+	ParseLi::ReadConfig("test_diag.in",&D,Options);
+	std::remove("test_diag.in");
+	Check(!Small.Wants(ParseLi::Severity::Error) && Small.DroppedCount() > 2,"diagnostics: full buffer wants nothing");
+	Check(Small.Take().size() == 2 && Small.Wants(ParseLi::Severity::Debug),"diagnostics: emptied buffer wants records again");
+}
+
+//A perfect hash places every key at a position of its own and finds each of them
+static void TestPerfectHash()
+{
+	for (std::size_t n : {1,2,3,7,100,333,1000}) {
+		std::vector<std::uint64_t> Hashes(n);
+		for (std::size_t i = 0; i < n; i++)
+			Hashes[i] = ParseLi::SchemaHash("KEY_" + std::to_string(i));
+		std::vector<std::uint32_t> Seeds(ParseLi::PerfectBuckets(n));
+		std::vector<std::size_t> Order(n), Start(ParseLi::PerfectBuckets(n) + 1);
+		std::unique_ptr<bool[]> Taken(new bool[n]());
+		Check(ParseLi::BuildPerfectHash(Hashes.data(),n,Seeds.data(),Order.data(),Start.data(),Taken.get()),"perfect hash: built");
+		std::vector<bool> Used(n,false);
+		bool Distinct = true;
+		for (std::uint64_t h : Hashes) {
+			std::size_t p = ParseLi::PerfectSlot(h,Seeds.data(),n);
+			Distinct = Distinct && p < n && !Used[p];
+			if (p < n)
+				Used[p] = true;
+		}
+		Check(Distinct,"perfect hash: every key has a position of its own");
+	}
+	std::uint64_t Twice[3] = {1,2,1};
+	std::uint32_t Seeds[ParseLi::PerfectBuckets(3)] = {};
+	std::size_t Order[3] = {}, Start[ParseLi::PerfectBuckets(3) + 1] = {};
+	bool Taken[3] = {};
+	Check(!ParseLi::BuildPerfectHash(Twice,3,Seeds,Order,Start,Taken),"perfect hash: equal hashes rejected");
+
+	ParseLi::Dict D;
+	for (int i = 0; i < 400; i++) {
+		std::string Key = "KEY_" + std::to_string(i);
+		switch (i % 3) {
+			case 0: D.add(Key,i); break;
+			case 1: D.add(Key,i + 0.5); break;
+			default: D.add(Key,"s" + std::to_string(i)); break;
+		}
+	}
+	D.add("KEY_0",1.5); //The same key with a second type
+	std::shared_ptr<const ParseLi::FrozenDict> F = D.Freeze(true);
+	Check(F->Perfect(),"perfect hash: frozen dictionary uses it");
+	bool Hits = F->TryGetDouble("KEY_0") == 1.5;
+	for (int i = 0; i < 400; i++) {
+		std::string Key = "KEY_" + std::to_string(i);
+		switch (i % 3) {
+			case 0: Hits = Hits && F->TryGetInt(Key) == i && !F->TryGetString(Key); break;
+			case 1: Hits = Hits && F->TryGetDouble(Key) == i + 0.5 && !F->TryGetInt(Key); break;
+			default: Hits = Hits && F->TryGetString(Key) == "s" + std::to_string(i) && !F->TryGetDouble(Key); break;
+		}
+	}
+	Check(Hits,"perfect hash: every key maps to its own value");
+	bool Misses = true;
+	for (int i = 400; i < 800; i++) {
+		std::string Key = "KEY_" + std::to_string(i);
+		Misses = Misses && !F->TryGetInt(Key) && !F->TryGetDouble(Key) && !F->TryGetString(Key);
+	}
+	Check(Misses && !F->TryGetInt("") && !F->TryGetInt("KEY_"),"perfect hash: absent keys miss");
+
+	static_assert(SettingsSchema.Find("NCELL") == 2,"schema: key found at compile time");
+	const char* Names[] = {"CFL_NUMBER","SCHEME","NCELL","FASTMODE","CASE"};
+	bool Found = true;
+	for (std::size_t i = 0; i < 5; i++)
+		Found = Found && SettingsSchema.Find(Names[i]) == i;
+	Check(Found,"schema: every key maps to its field");
+	bool Absent = true;
+	for (int i = 0; i < 400; i++)
+		Absent = Absent && SettingsSchema.Find("KEY_" + std::to_string(i)) == SettingsSchema.npos;
+	Check(Absent && SettingsSchema.Find("") == SettingsSchema.npos && SettingsSchema.Find("NCEL") == SettingsSchema.npos,"schema: absent keys miss");
+}
+
+//A batched lookup finds what the individual lookups find
+static void TestGetMany()
+{
+	using ParseLi::ValueType;
+	ParseLi::Dict D;
+	std::vector<int> Ints = {1,2,3};
+	std::vector<double> Doubles = {0.5,1.5};
+	for (int i = 0; i < 50; i++) {
+		std::string Key = "KEY_" + std::to_string(i);
+		D.add(Key,i);
+		if (i % 2)
+			D.add(Key,i + 0.25);
+		if (i % 3 == 0)
+			D.add(Key,"s" + std::to_string(i));
+	}
+	D.add("INTS",ParseLi::Span<const int>(Ints));
+	D.add("DOUBLES",ParseLi::Span<const double>(Doubles));
+
+	//Every type of every key (present or not), some with their hash given
+	std::vector<std::string> Names;
+	for (int i = 0; i < 60; i++)
+		Names.push_back("KEY_" + std::to_string(i));
+	Names.push_back("INTS");
+	Names.push_back("DOUBLES");
+	const ValueType Types[] = {ValueType::Int,ValueType::Double,ValueType::String,ValueType::IntArray,ValueType::DoubleArray};
+	std::vector<ParseLi::KeyRequest> Keys;
+	for (std::string const &Name : Names)
+		for (ValueType T : Types) {
+			Keys.push_back({Name,T});
+			if (Keys.size() % 4 == 0)
+				Keys.back().Hash = ParseLi::ValueTable::HashKey(Name);
+		}
+	std::vector<ParseLi::KeyResult> Out(Keys.size());
+	std::size_t Found = D.GetMany(Keys,Out);
+
+	std::size_t Expected = 0;
+	bool Same = Keys.size() > 8;
+	for (std::size_t i = 0; i < Keys.size(); i++) {
+		std::string_view K = Keys[i].Key;
+		ParseLi::KeyResult const &R = Out[i];
+		switch (Keys[i].Type) {
+			case ValueType::Int: {
+				std::optional<int> V = D.TryGetInt(K);
+				Same = Same && R.Found == V.has_value() && (!V || R.Int == *V);
+				Expected += V.has_value();
+				break;
+			}
+			case ValueType::Double: {
+				std::optional<double> V = D.TryGetDouble(K);
+				Same = Same && R.Found == V.has_value() && (!V || R.Double == *V);
+				Expected += V.has_value();
+				break;
+			}
+			case ValueType::String: {
+				std::optional<std::string> V = D.TryGetString(K);
+				Same = Same && R.Found == V.has_value() && (!V || R.String == *V);
+				Expected += V.has_value();
+				break;
+			}
+			case ValueType::IntArray: {
+				std::optional<ParseLi::Span<const int>> V = D.TryGetIntArray(K);
+				Same = Same && R.Found == V.has_value() && (!V || std::equal(R.Ints.begin(),R.Ints.end(),V->begin(),V->end()));
+				Expected += V.has_value();
+				break;
+			}
+			case ValueType::DoubleArray: {
+				std::optional<ParseLi::Span<const double>> V = D.TryGetDoubleArray(K);
+				Same = Same && R.Found == V.has_value() && (!V || std::equal(R.Doubles.begin(),R.Doubles.end(),V->begin(),V->end()));
+				Expected += V.has_value();
+				break;
+			}
+		}
+	}
+	Check(Same,"GetMany: each result matches TryGet");
+	Check(Found == Expected && Found == 50 + 25 + 17 + 2,"GetMany: number found");
+
+	bool Threw = false;
+	try {
+		D.GetMany(Keys,ParseLi::Span<ParseLi::KeyResult>(Out.data(),Keys.size() - 1));
+	} catch (std::invalid_argument const&) {
+		Threw = true;
+	}
+	Check(Threw,"GetMany: too few results throws");
+	Check(D.GetMany(ParseLi::Span<const ParseLi::KeyRequest>(),ParseLi::Span<ParseLi::KeyResult>()) == 0,"GetMany: no keys");
+}
+
 int GetScheme(std::string Scheme)
 {
 	if (Scheme.compare("HLLE") == 0)
@@ -23,8 +842,8 @@ int main(int argc, char** argv)
 	
 	//Example of read operation (returns defaults if values are not found)
 	//Set CFL number to value provided; otherwise default to 0.5
-	double CFL_NUMBER = (D.CheckDouble("CFL_NUMBER")) ? D.GetDouble("CFL_NUMBER") : 0.5;
-	int SCHEME = (D.CheckString("SCHEME")) ? GetScheme(D.GetString("SCHEME")) : 1;
+	double CFL_NUMBER = D.GetOr("CFL_NUMBER",0.5);
+	int SCHEME = GetScheme(D.GetOr("SCHEME","HLLE"));
 	//Add default scheme to dictionary if not already present
 	if (!D.CheckString("SCHEME")) D.add("SCHEME","HLLE");
 	
@@ -61,4 +880,52 @@ int main(int argc, char** argv)
 	std::ifstream I1("Example.in");
 	ParseLi::ReadConfig(I1,&D3,false);
 	D3.Dump();
+	
+	//Lock-free snapshot for read-only use (e.g. by worker threads)
+	ParseLi::SnapshotPublisher Config(D3.Freeze());
+	std::shared_ptr<const ParseLi::FrozenDict> Snapshot = Config.Acquire();
+	printf("Frozen CFL_NUMBER is %lf\n",Snapshot->GetDouble("CFL_NUMBER"));
+	D3.set("CFL_NUMBER",0.75);
+	Config.Publish(D3);
+	printf("Republished CFL_NUMBER is %lf (old snapshot still reads %lf)\n",Config.Acquire()->GetDouble("CFL_NUMBER"),Snapshot->GetDouble("CFL_NUMBER"));
+	
+	//Resolve a key once for repeated reads
+	ParseLi::Dict::Handle<double> CFL = D3.GetHandle<double>("CFL_NUMBER");
+	printf("CFL_NUMBER through handle is %lf\n",CFL.Get());
+	
+	//Read into a struct through a schema (other keys are reported, here to a buffer)
+	Settings Solver;
+	ParseLi::BufferedDiagnostics Unread(ParseLi::Severity::Warning);
+	ParseLi::ReadOptions SchemaOptions;
+	SchemaOptions.Diagnostics = &Unread;
+	ParseLi::ReadConfig("Example.in",SettingsSchema,Solver,SchemaOptions);
+	printf("Schema read CFL_NUMBER %lf, SCHEME %d, NCELL %d, FASTMODE %d, CASE %s (%zu other keys)\n",
+		Solver.CFL_NUMBER,static_cast<int>(Solver.SCHEME),Solver.NCELL,Solver.FASTMODE,Solver.CASE.c_str(),Unread.Take().size());
+	
+	//Read in the background while doing other work
+	ParseLi::Dict D4;
+	std::future<bool> Loading = ParseLi::ReadConfigAsync("Example.in",&D4);
+	if (Loading.get())
+		printf("Background read NCELL is %d\n",D4.GetInt("NCELL"));
+	
+	TestDefaultDiagnostics();
+	TestPerfectHash();
+	TestGetMany();
+	TestFinalLine();
+	TestHandleUnderWrites();
+	TestTokenScanners();
+	TestHandleReclaim();
+	TestPrefixRange();
+	TestArrays();
+	TestConcurrentDict();
+	TestDictAssignment();
+	TestBinaryArrays();
+	TestIncludeGraph();
+	TestAddExisting();
+	TestCache();
+	TestParseChunked();
+	TestWatcher();
+	TestWatcherArena();
+	printf("%d check(s) failed\n",Failures);
+	return Failures ? 1 : 0;
 }